@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <new>
+#include "allocstats.hpp"
+
+long long allocCounters::totalCalls() const {
+    long long total = 0;
+    for (long long calls : this->calls) {
+        total += calls;
+    }
+    return total;
+}
+
+long long allocCounters::totalBytes() const {
+    long long total = 0;
+    for (long long bytes : this->bytes) {
+        total += bytes;
+    }
+    return total;
+}
+
+allocCounters &allocCounters::operator+=(const allocCounters &other) {
+    for (int i = 0; i < sites; i++) {
+        this->calls[i] += other.calls[i];
+        this->bytes[i] += other.bytes[i];
+    }
+    return *this;
+}
+
+allocCounters allocCounters::operator-(const allocCounters &other) const {
+    allocCounters difference = *this;
+    for (int i = 0; i < sites; i++) {
+        difference.calls[i] -= other.calls[i];
+        difference.bytes[i] -= other.bytes[i];
+    }
+    return difference;
+}
+
+std::string allocCounters::siteName(int site) {
+    switch (static_cast<allocSite>(site)) {
+        case allocSite::moveGeneration:
+            return "moveGeneration";
+        case allocSite::boardCopy:
+            return "boardCopy";
+        case allocSite::heuristic:
+            return "heuristic";
+        default:
+            return "other";
+    }
+}
+
+#ifdef OTHELLO_ALLOC_STATS
+
+// Plain thread-local counters: they must be usable from operator new at any
+// point in a thread's life, so they cannot have constructors or destructors
+namespace {
+    thread_local long long siteCalls[allocCounters::sites];
+    thread_local long long siteBytes[allocCounters::sites];
+    thread_local int currentSite = static_cast<int>(allocSite::other);
+}
+
+bool allocStatsEnabled() {
+    return true;
+}
+
+allocCounters threadAllocCounters() {
+    allocCounters counters;
+    for (int i = 0; i < allocCounters::sites; i++) {
+        counters.calls[i] = siteCalls[i];
+        counters.bytes[i] = siteBytes[i];
+    }
+    return counters;
+}
+
+allocScope::allocScope(allocSite site)
+    : previous(static_cast<allocSite>(currentSite)) {
+    currentSite = static_cast<int>(site);
+}
+
+allocScope::~allocScope() {
+    currentSite = static_cast<int>(this->previous);
+}
+
+void *operator new(std::size_t size) {
+    siteCalls[currentSite]++;
+    siteBytes[currentSite] += size;
+
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#else
+
+bool allocStatsEnabled() {
+    return false;
+}
+
+allocCounters threadAllocCounters() {
+    return allocCounters();
+}
+
+#endif // OTHELLO_ALLOC_STATS
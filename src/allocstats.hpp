@@ -0,0 +1,63 @@
+#ifndef ALLOCSTATS_HPP
+#define ALLOCSTATS_HPP
+
+#include <array>
+#include <string>
+
+// Heap allocation counters for the search hot path. Counting is only
+// compiled in with -DOTHELLO_ALLOC_STATS (make ALLOC_STATS=1), which
+// replaces the global operator new. Otherwise every counter stays zero and
+// ALLOC_SCOPE expands to nothing.
+
+// Call sites that allocations are attributed to
+enum class allocSite {
+    moveGeneration,     // findLegalMoves
+    boardCopy,          // copying boards onto the node stack, updateBoard
+    heuristic,          // evaluate
+    other,
+    count
+};
+
+struct allocCounters {
+    static const int sites = static_cast<int>(allocSite::count);
+    std::array<long long, sites> calls = {};
+    std::array<long long, sites> bytes = {};
+
+    long long totalCalls() const;
+    long long totalBytes() const;
+
+    allocCounters &operator+=(const allocCounters &other);
+    allocCounters operator-(const allocCounters &other) const;
+
+    static std::string siteName(int site);
+};
+
+// True if this build counts allocations
+bool allocStatsEnabled();
+
+// Counters of the calling thread since it started
+allocCounters threadAllocCounters();
+
+#ifdef OTHELLO_ALLOC_STATS
+
+// Attributes the calling thread's allocations to site until destroyed
+class allocScope {
+    public:
+        explicit allocScope(allocSite site);
+        ~allocScope();
+
+    private:
+        allocSite previous;
+};
+
+#define ALLOC_SCOPE_NAME(line) allocScope_ ## line
+#define ALLOC_SCOPE_AT(site, line) allocScope ALLOC_SCOPE_NAME(line)(site)
+#define ALLOC_SCOPE(site) ALLOC_SCOPE_AT(site, __LINE__)
+
+#else
+
+#define ALLOC_SCOPE(site)
+
+#endif // OTHELLO_ALLOC_STATS
+
+#endif // ALLOCSTATS_HPP
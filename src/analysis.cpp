@@ -0,0 +1,535 @@
+// Headless batch analysis.
+//
+// Usage: othello.exe --analyze [--depth N] [--time S] [--nodes N]
+//                    [--threads N] [--multipv N] [--format csv|json]
+//                    [--output FILE] FILE...
+//
+// Every position in the input files is searched on a thread pool and one
+// record per position is written, in input order, with the best move,
+// score (from the side to move), completed depth, nodes and time. Without
+// any limit, positions are searched to depth 6. With --multipv N the best N
+// root moves (0 for all) are scored exactly and listed with their principal
+// variations; other moves are listed with an upper bound ("<=").
+
+#include <cctype>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include "analysis.hpp"
+#include "corpus.hpp"
+#include "game.hpp"
+#include "threadpool.hpp"
+
+std::string index2string(int index) {
+    if (index < 0 || index >= boardSquares) {
+        return "pass";
+    }
+
+    return squareName(index);
+}
+
+int string2index(const std::string &coord) {
+    if (coord == "pass" || coord == "PASS" || coord == "PA") {
+        return -1;
+    }
+
+    int index = squareIndex(coord);
+    return (index < 0) ? -2 : index;
+}
+
+/**
+ * @brief 解析单行局面
+ *
+ * @param line 一行局面文本，格式见 analysis.hpp
+ * @param task 写入棋盘、轮到的一方以及该局面自己的搜索限制
+ * @return 解析成功时返回 true
+ */
+bool parsePositionLine(const std::string &line, analysisTask &task) {
+    std::string text = line.substr(0, line.find_first_of(";#"));
+    std::istringstream iss(text);
+    std::string squares, side, option;
+
+    if (!(iss >> squares >> side) || (int) squares.length() != boardSquares) {
+        return false;
+    }
+
+    task.board.positions.assign(boardSquares, 0);
+    for (int i = 0; i < boardSquares; i++) {
+        switch (squares[i]) {
+            case 'X':
+            case 'x':
+            case '*':
+            case '1':
+                task.board.positions[i] = 1;
+                break;
+            case 'O':
+            case 'o':
+            case '2':
+                task.board.positions[i] = -1;
+                break;
+            case '-':
+            case '.':
+            case '0':
+                break;
+            default:
+                return false;
+        }
+    }
+    task.board.discsOnBoard = boardSquares - std::count(task.board.positions.begin(),
+            task.board.positions.end(), 0);
+
+    switch (side[0]) {
+        case 'X':
+        case 'x':
+        case 'B':
+        case 'b':
+        case '*':
+        case '1':
+            task.toMove = 1;
+            break;
+        case 'O':
+        case 'o':
+        case 'W':
+        case 'w':
+        case '2':
+            task.toMove = -1;
+            break;
+        default:
+            return false;
+    }
+
+    try {
+        while (iss >> option) {
+            size_t eq = option.find('=');
+            if (eq == std::string::npos) {
+                return false;
+            }
+
+            std::string key = option.substr(0, eq);
+            std::string value = option.substr(eq + 1);
+            if (key == "depth") {
+                task.limits.depth = std::stoi(value);
+            }
+            else if (key == "time") {
+                task.limits.time = std::stof(value);
+            }
+            else if (key == "nodes") {
+                task.limits.nodes = std::stoll(value);
+            }
+            else {
+                return false;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 读取一个输入文件中的全部局面
+ *
+ * 首行为 boardSquares 个格子的文件按单行格式逐行解析，否则按存档格式解析，
+ * 存档中的时间限制作为该局面的时间限制。
+ *
+ * @param fileName 输入文件名
+ * @param defaults 命令行给出的默认搜索限制
+ * @param tasks 追加解析得到的局面
+ * @param error 解析失败时写入错误信息
+ * @return 解析成功时返回 true
+ */
+bool readPositions(const std::string &fileName, const searchLimits &defaults,
+        std::vector<analysisTask> &tasks, std::string &error) {
+    if (isCorpusFile(fileName)) {
+        othelloCorpusReader corpus;
+        if (!corpus.open(fileName)) {
+            error = corpus.error();
+            return false;
+        }
+
+        tasks.reserve(tasks.size() + corpus.size());
+        for (uint64_t i = 0; i < corpus.size(); i++) {
+            analysisTask task;
+            task.id = fileName + ":" + std::to_string(i);
+            task.limits = defaults;
+            corpus[i].toBoard(task.board);
+            task.toMove = corpus[i].toMove;
+            tasks.push_back(task);
+        }
+        return true;
+    }
+
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.good()) {
+        error = fileName + ": file does not exist";
+        return false;
+    }
+
+    // Line-format files start with a token of boardSquares squares, possibly
+    // after blank and comment lines; anything else is treated as a save file
+    std::string line;
+    int lineNum = 0;
+    do {
+        if (!std::getline(ifs, line)) {
+            return true;
+        }
+        lineNum++;
+    }
+    while (line.find_first_not_of(" \t\r") == std::string::npos
+            || line.find_first_not_of(" \t") == line.find_first_of(";#"));
+
+    std::string first = line.substr(0, line.find_first_of(" \t;#"));
+    if ((int) first.length() != boardSquares) {
+        ifs.clear();
+        ifs.seekg(0);
+
+        analysisTask task;
+        task.id = fileName;
+        task.limits = defaults;
+        try {
+            if (!othelloGame::parseSaveFile(ifs, task.board, task.toMove,
+                        error)) {
+                error = fileName + ": " + error;
+                return false;
+            }
+        }
+        catch (const std::exception &) {
+            error = fileName + ": invalid time limit";
+            return false;
+        }
+        // The file's time limit, unless one was given on the command line
+        if (defaults.time <= 0) {
+            task.limits.time = task.board.timeLimit;
+        }
+        tasks.push_back(task);
+        return true;
+    }
+
+    do {
+        if (line.find_first_not_of(" \t\r") == std::string::npos
+                || line.find_first_not_of(" \t") == line.find_first_of(";#")) {
+            continue;
+        }
+
+        analysisTask task;
+        task.id = fileName + ":" + std::to_string(lineNum);
+        task.limits = defaults;
+        if (!parsePositionLine(line, task)) {
+            error = task.id + ": invalid position";
+            return false;
+        }
+        tasks.push_back(task);
+    }
+    while (std::getline(ifs, line) && ++lineNum);
+
+    return true;
+}
+
+// Principal variation as space-separated coordinates
+std::string pvString(const std::vector<int> &pv) {
+    std::string text;
+    for (int square : pv) {
+        text += (text.empty() ? "" : " ") + index2string(square);
+    }
+    return text;
+}
+
+// Quotes text as a JSON string
+std::string jsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        }
+        else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// Writes results in input order as they complete
+class analysisWriter {
+    public:
+        analysisWriter(std::ostream &os, bool json, bool lines, size_t count)
+            : os(os), json(json), lines(lines), ids(count), results(count),
+              done(count, false) {}
+
+        void header() {
+            if (this->json) {
+                this->os << "[" << std::endl;
+            }
+            else {
+                this->os << "id,move,score,depth,nodes,time"
+                    << (allocStatsEnabled() ? ",allocations,bytes" : "")
+                    << (this->lines ? ",lines" : "") << std::endl;
+            }
+        }
+
+        void footer() {
+            if (this->json) {
+                this->os << "]" << std::endl;
+            }
+        }
+
+        void submit(size_t index, const std::string &id,
+                const searchResult &result) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->ids[index] = id;
+            this->results[index] = result;
+            this->done[index] = true;
+
+            while (this->next < this->done.size() && this->done[this->next]) {
+                this->write(this->ids[this->next], this->results[this->next]);
+                this->next++;
+            }
+            this->os.flush();
+        }
+
+    private:
+        std::ostream &os;
+        bool json;
+        // Whether to write the root moves of multi-PV searches
+        bool lines;
+        std::vector<std::string> ids;
+        std::vector<searchResult> results;
+        std::vector<bool> done;
+        size_t next = 0;
+        std::mutex mutex;
+
+        void write(const std::string &id, const searchResult &result) {
+            if (this->json) {
+                this->os << "  {\"id\": " << jsonString(id) << ", \"move\": \""
+                    << index2string(result.move) << "\", \"score\": "
+                    << result.score << ", \"depth\": " << result.depth
+                    << ", \"nodes\": " << result.nodes << ", \"time\": "
+                    << result.time;
+                if (allocStatsEnabled()) {
+                    this->os << ", \"allocations\": "
+                        << result.allocations.totalCalls() << ", \"bytes\": "
+                        << result.allocations.totalBytes();
+                }
+                if (this->lines) {
+                    this->os << ", \"lines\": [";
+                    for (size_t i = 0; i < result.lines.size(); i++) {
+                        const searchLine &line = result.lines[i];
+                        this->os << (i > 0 ? ", " : "") << "{\"move\": \""
+                            << index2string(line.move) << "\", \"score\": "
+                            << line.score << ", \"bound\": \""
+                            << (line.bound == boundType::exact ? "exact" : "upper")
+                            << "\", \"pv\": \"" << pvString(line.pv) << "\"}";
+                    }
+                    this->os << "]";
+                }
+                this->os << "}"
+                    << (this->next + 1 < this->done.size() ? "," : "")
+                    << std::endl;
+            }
+            else {
+                this->os << id << "," << index2string(result.move) << ","
+                    << result.score << "," << result.depth << ","
+                    << result.nodes << "," << result.time;
+                if (allocStatsEnabled()) {
+                    this->os << "," << result.allocations.totalCalls() << ","
+                        << result.allocations.totalBytes();
+                }
+                if (this->lines) {
+                    this->os << ",";
+                    for (size_t i = 0; i < result.lines.size(); i++) {
+                        const searchLine &line = result.lines[i];
+                        this->os << (i > 0 ? " " : "")
+                            << index2string(line.move)
+                            << (line.bound == boundType::exact ? "=" : "<=")
+                            << line.score;
+                    }
+                }
+                this->os << std::endl;
+            }
+        }
+};
+
+int runAnalysis(int argc, char **argv) {
+    searchLimits defaults;
+    int numThreads = std::thread::hardware_concurrency();
+    bool json = false;
+    std::string outputFile, cacheFile, hashFile, sharedName;
+    long long hashMegabytes = -1;
+    tableMemory memory;
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) {
+                inputs.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--depth") {
+                defaults.depth = std::stoi(value);
+            }
+            else if (arg == "--time") {
+                defaults.time = std::stof(value);
+            }
+            else if (arg == "--nodes") {
+                defaults.nodes = std::stoll(value);
+            }
+            else if (arg == "--threads") {
+                numThreads = std::stoi(value);
+            }
+            else if (arg == "--multipv") {
+                defaults.multiPV = std::stoi(value);
+            }
+            else if (arg == "--format") {
+                if (value != "csv" && value != "json") {
+                    throw std::invalid_argument(value);
+                }
+                json = (value == "json");
+            }
+            else if (arg == "--output") {
+                outputFile = value;
+            }
+            else if (arg == "--endgame-cache") {
+                cacheFile = value;
+            }
+            else if (arg == "--hash") {
+                hashMegabytes = std::stoll(value);
+            }
+            else if (arg == "--hash-file") {
+                hashFile = value;
+            }
+            else if (arg == "--shared-hash") {
+                sharedName = value;
+            }
+            else if (arg == "--huge-pages") {
+                if (value != "on" && value != "off") {
+                    throw std::invalid_argument(value);
+                }
+                memory.hugePages = (value == "on");
+            }
+            else if (arg == "--numa") {
+                if (value != "local" && value != "interleave") {
+                    throw std::invalid_argument(value);
+                }
+                memory.interleave = (value == "interleave");
+            }
+            else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cerr << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    std::vector<analysisTask> tasks;
+    std::string error;
+    for (const std::string &input : inputs) {
+        if (!readPositions(input, defaults, tasks, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    // Depth 6 only for positions left without any limit by the options,
+    // their own line or their save file
+    for (analysisTask &task : tasks) {
+        searchLimits &limits = task.limits;
+        if (limits.depth <= 0 && limits.time <= 0 && limits.nodes <= 0) {
+            limits.depth = 6;
+        }
+    }
+
+    std::ofstream ofs;
+    if (!outputFile.empty()) {
+        ofs.open(outputFile.c_str());
+        if (!ofs.good()) {
+            std::cerr << "Could not write " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    othelloEndgameCache cache;
+    if (!cacheFile.empty() && !cache.open(cacheFile)) {
+        std::cerr << cache.error() << std::endl;
+        return 1;
+    }
+
+    // One table shared by every worker, optionally carried over from an
+    // earlier run or shared with other processes
+    std::unique_ptr<othelloTable> table;
+    size_t hashBytes = (hashMegabytes > 0)
+        ? (size_t) hashMegabytes << 20 : 64 << 20;
+    if (!sharedName.empty()) {
+        table = othelloTable::openShared(sharedName, hashBytes, error,
+                memory);
+        if (!table) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+    else if (hashMegabytes > 0 || !hashFile.empty()) {
+        table.reset(new othelloTable(hashBytes, memory));
+    }
+    if (table) {
+        if (!table->placementError().empty()) {
+            std::cerr << table->placementError() << std::endl;
+        }
+        std::ifstream exists(hashFile.c_str());
+        if (!hashFile.empty() && exists.good()
+                && !table->load(hashFile, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    analysisWriter writer(outputFile.empty() ? std::cout : ofs, json,
+            defaults.multiPV != 1, tasks.size());
+    writer.header();
+
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    std::vector<std::unique_ptr<othelloPlayer>> players;
+    for (int i = 0; i < numThreads; i++) {
+        players.emplace_back(new othelloPlayer());
+        players.back()->computer = true;
+        players.back()->endgameCache = cache.isOpen() ? &cache : nullptr;
+        players.back()->table = table.get();
+    }
+
+    {
+        othelloThreadPool pool(numThreads);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            pool.submit([&, i](int worker) {
+                othelloPlayer &player = *players[worker];
+                player.color = tasks[i].toMove;
+                searchResult result = player.analyze(tasks[i].board,
+                        tasks[i].limits);
+                writer.submit(i, tasks[i].id, result);
+            });
+        }
+        pool.wait();
+    }
+
+    writer.footer();
+    if (!hashFile.empty() && !table->save(hashFile, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    return 0;
+}
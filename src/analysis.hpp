@@ -0,0 +1,38 @@
+#ifndef ANALYSIS_HPP
+#define ANALYSIS_HPP
+
+#include <string>
+#include <vector>
+#include "player.hpp"
+
+// A position to analyse, with its own search limits
+struct analysisTask {
+    std::string id;
+    othelloBoard board;
+    int toMove = 1;
+    searchLimits limits;
+};
+
+// Reads positions from a save file (see README) or from a file with one
+// position per line: boardSquares squares (64 on the standard board;
+// 'X'/'*'/'1' black, 'O'/'2' white, '-'/'.'/'0' empty), the side to move ('X'/'B'/'1' or 'O'/'W'/'2'), and
+// optional "depth=N", "time=S" and "nodes=N" overrides. Text after ';' or
+// '#' is ignored. Position corpus files (see corpus.hpp) are read as well.
+// Returns false and sets error if the file is malformed.
+bool readPositions(const std::string &fileName, const searchLimits &defaults,
+        std::vector<analysisTask> &tasks, std::string &error);
+
+// Parses a single one-line position. Returns false if it is malformed.
+bool parsePositionLine(const std::string &line, analysisTask &task);
+
+// Converts a square index to a coordinate string such as "C4"
+std::string index2string(int index);
+
+// Parses a coordinate such as "C4" or "c4", or "pass" as -1. Returns -2 if
+// the string is neither.
+int string2index(const std::string &coord);
+
+// Entry point for "othello.exe --analyze"
+int runAnalysis(int argc, char **argv);
+
+#endif // ANALYSIS_HPP
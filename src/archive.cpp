@@ -0,0 +1,367 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "archive.hpp"
+
+namespace {
+    struct crcTable {
+        uint32_t entries[256];
+
+        crcTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+                }
+                this->entries[i] = crc;
+            }
+        }
+    };
+}
+
+int finalResult(const othelloBoard &board) {
+    int black = std::count(board.positions.begin(), board.positions.end(), 1);
+    int white = std::count(board.positions.begin(), board.positions.end(), -1);
+    int empty = boardSquares - black - white;
+    if (black > white) {
+        black += empty;
+    }
+    else if (white > black) {
+        white += empty;
+    }
+    return black - white;
+}
+
+uint32_t checksum32(const void *data, size_t size, uint32_t crc) {
+    static const crcTable table;
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief 将棋盘设为对局的起始局面
+ *
+ * 只改写 positions 中的值，不重新分配，因此同一个棋盘可以在多盘棋之间复用。
+ *
+ * @param board 写入起始局面
+ */
+void gameView::startPosition(othelloBoard &board) const {
+    board.startPosition();
+    if (this->start != nullptr) {
+        for (int i = 0; i < boardSquares; i++) {
+            int square = (this->start[i/4] >> (2*(i % 4))) & 3;
+            board.positions[i] = (square == 1) ? 1 : (square == 2) ? -1 : 0;
+        }
+        board.discsOnBoard = boardSquares - std::count(
+                board.positions.begin(), board.positions.end(), 0);
+    }
+}
+
+othelloArchiveWriter::~othelloArchiveWriter() {
+    if (this->ofs.is_open()) {
+        this->close();
+    }
+}
+
+bool othelloArchiveWriter::open(const std::string &fileName) {
+    this->ofs.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!this->ofs.good()) {
+        return false;
+    }
+
+    archiveHeader header = {};
+    std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+    header.version = archiveVersion;
+    header.boardSide = (boardSide == 8) ? 0 : boardSide;
+    this->ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->block.reserve(blockBytes + 512);
+    this->blockGames = 0;
+    this->written = 0;
+    return this->ofs.good();
+}
+
+/**
+ * @brief 追加一盘棋
+ *
+ * 记录写入当前块；块的数据达到 blockBytes 时整块写出。
+ *
+ * @param game 对局记录
+ * @return 对局符合格式且写入成功时返回 true
+ */
+bool othelloArchiveWriter::add(const gameRecord &game) {
+    archiveGame record = {};
+    for (int square : game.moves) {
+        if (square < -1 || square >= boardSquares) {
+            return false;
+        }
+    }
+    int moveCount = std::count_if(game.moves.begin(), game.moves.end(),
+            [](int square) { return square != -1; });
+    if (moveCount > 255 || game.black.size() > 255 || game.white.size() > 255
+            || (!game.start.empty()
+                && (int) game.start.size() != boardSquares)) {
+        return false;
+    }
+
+    record.timeControl = game.timeControl;
+    record.result = game.result;
+    record.flags = (game.start.empty() ? 0 : customStart)
+        | (game.toMove == -1 ? whiteFirst : 0);
+    record.moveCount = moveCount;
+    record.blackLength = game.black.size();
+    record.whiteLength = game.white.size();
+
+    const char *bytes = reinterpret_cast<const char *>(&record);
+    this->block.insert(this->block.end(), bytes, bytes + sizeof(record));
+    this->block.insert(this->block.end(), game.black.begin(), game.black.end());
+    this->block.insert(this->block.end(), game.white.begin(), game.white.end());
+    if (!game.start.empty()) {
+        char packed[archiveStartBytes] = {};
+        for (int i = 0; i < boardSquares; i++) {
+            int square = (game.start[i] == 1) ? 1 : (game.start[i] == -1) ? 2 : 0;
+            packed[i/4] |= square << (2*(i % 4));
+        }
+        this->block.insert(this->block.end(), packed,
+                packed + archiveStartBytes);
+    }
+    for (int square : game.moves) {
+        if (square != -1) {
+            this->block.push_back((char) square);
+        }
+    }
+
+    this->blockGames++;
+    this->written++;
+    if (this->block.size() >= blockBytes) {
+        return this->flush();
+    }
+    return true;
+}
+
+bool othelloArchiveWriter::flush() {
+    if (this->blockGames == 0) {
+        return this->ofs.good();
+    }
+
+    archiveBlock header = {};
+    header.games = this->blockGames;
+    header.bytes = this->block.size();
+    header.checksum = checksum32(this->block.data(), this->block.size());
+    this->ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->ofs.write(this->block.data(), this->block.size());
+    this->block.clear();
+    this->blockGames = 0;
+    return this->ofs.good();
+}
+
+bool othelloArchiveWriter::close() {
+    bool ok = this->flush();
+    this->ofs.close();
+    return ok && !this->ofs.fail();
+}
+
+uint64_t othelloArchiveWriter::games() const {
+    return this->written;
+}
+
+othelloArchiveReader::~othelloArchiveReader() {
+    this->close();
+}
+
+/**
+ * @brief 以只读方式映射归档文件
+ *
+ * @param fileName 归档文件
+ * @return 文件头有效时返回 true，否则设置 error()
+ */
+bool othelloArchiveReader::open(const std::string &fileName) {
+    this->close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return this->fail(fileName + ": file does not exist");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(archiveHeader)) {
+        ::close(fd);
+        return this->fail(fileName + ": not a game archive");
+    }
+
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return this->fail(fileName + ": could not map file");
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    this->mapping = addr;
+    this->data = static_cast<const char *>(addr);
+    this->size = st.st_size;
+
+    archiveHeader header;
+    std::memcpy(&header, this->data, sizeof(header));
+    if (std::memcmp(header.magic, archiveMagic, sizeof(archiveMagic)) != 0
+            || header.version != archiveVersion) {
+        this->close();
+        return this->fail(fileName + ": not a game archive");
+    }
+    if ((header.boardSide == 0 ? 8 : (int) header.boardSide) != boardSide) {
+        this->close();
+        return this->fail(fileName + ": archive of a different board size");
+    }
+
+    this->rewind();
+    return true;
+}
+
+void othelloArchiveReader::close() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->size);
+    }
+    this->mapping = nullptr;
+    this->data = nullptr;
+    this->size = 0;
+}
+
+void othelloArchiveReader::rewind() {
+    this->offset = sizeof(archiveHeader);
+    this->blockEnd = this->offset;
+    this->blockGames = 0;
+    this->message.clear();
+}
+
+/**
+ * @brief 读取下一盘棋
+ *
+ * 进入新块时先校验块的长度与 CRC-32；对局内容直接指向映射的内存，不做任何分配。
+ *
+ * @param game 写入对局视图
+ * @return 读到对局时返回 true；到达末尾或数据损坏时返回 false
+ */
+bool othelloArchiveReader::next(gameView &game) {
+    while (this->blockGames == 0) {
+        if (this->offset != this->blockEnd) {
+            return this->fail("block ends inside a game record");
+        }
+        if (this->data == nullptr || this->offset == this->size) {
+            return false;
+        }
+
+        archiveBlock header;
+        if (this->size - this->offset < sizeof(header)) {
+            return this->fail("truncated block header");
+        }
+        std::memcpy(&header, this->data + this->offset, sizeof(header));
+        this->offset += sizeof(header);
+        if (this->size - this->offset < header.bytes) {
+            return this->fail("truncated block");
+        }
+        if (checksum32(this->data + this->offset, header.bytes)
+                != header.checksum) {
+            return this->fail("block checksum mismatch");
+        }
+        this->blockEnd = this->offset + header.bytes;
+        this->blockGames = header.games;
+    }
+
+    archiveGame record;
+    if (this->blockEnd - this->offset < sizeof(record)) {
+        return this->fail("truncated game record");
+    }
+    std::memcpy(&record, this->data + this->offset, sizeof(record));
+    size_t length = sizeof(record) + record.blackLength + record.whiteLength
+        + ((record.flags & customStart) ? archiveStartBytes : 0)
+        + record.moveCount;
+    if (this->blockEnd - this->offset < length) {
+        return this->fail("truncated game record");
+    }
+
+    const char *p = this->data + this->offset + sizeof(record);
+    game.black = p;
+    game.blackLength = record.blackLength;
+    p += record.blackLength;
+    game.white = p;
+    game.whiteLength = record.whiteLength;
+    p += record.whiteLength;
+    game.start = nullptr;
+    if (record.flags & customStart) {
+        game.start = reinterpret_cast<const uint8_t *>(p);
+        p += archiveStartBytes;
+    }
+    game.moves = reinterpret_cast<const uint8_t *>(p);
+    game.moveCount = record.moveCount;
+    game.result = record.result;
+    game.timeControl = record.timeControl;
+    game.toMove = (record.flags & whiteFirst) ? -1 : 1;
+
+    this->offset += length;
+    this->blockGames--;
+    return true;
+}
+
+const std::string &othelloArchiveReader::error() const {
+    return this->message;
+}
+
+bool othelloArchiveReader::fail(const std::string &message) {
+    this->message = message;
+    this->blockGames = 0;
+    this->offset = this->blockEnd = this->size;
+    return false;
+}
+
+/**
+ * @brief 在棋盘上重放一盘棋
+ *
+ * 轮到的一方无子可下时自动弃权。对局在所有走法之后结束且 checkResult 为真
+ * 时，检查终局子数差（空格计入胜方）与记录的结果是否一致。
+ *
+ * @param game 对局
+ * @param board 用于重放的棋盘，可在多盘棋之间复用
+ * @param visit 每步（包括弃权）之前调用，参数为局面、轮到的一方与走法
+ * @param checkResult 是否检查记录的结果
+ * @return 所有走法合法且结果一致时返回 true
+ */
+bool othelloArchiveReader::replay(const gameView &game, othelloBoard &board,
+        std::function<void(const othelloBoard &, int, int)> visit,
+        bool checkResult) {
+    game.startPosition(board);
+    int toMove = game.toMove;
+
+    for (int i = 0; i < game.moveCount; i++) {
+        board.findLegalMoves(toMove, &board.moves);
+        if (board.moves.empty()) {
+            if (visit) {
+                visit(board, toMove, -1);
+            }
+            toMove = -toMove;
+            board.findLegalMoves(toMove, &board.moves);
+        }
+
+        auto move = board.moves.find(game.moves[i]);
+        if (move == board.moves.end()) {
+            return false;
+        }
+        if (visit) {
+            visit(board, toMove, game.moves[i]);
+        }
+        board.updateBoard(toMove, *move);
+        board.discsOnBoard++;
+        toMove = -toMove;
+    }
+
+    board.findLegalMoves(toMove, &board.moves);
+    if (board.moves.empty()) {
+        board.findLegalMoves(-toMove, &board.moves);
+    }
+    bool over = board.moves.empty();
+    board.moves.clear();
+    return !checkResult || !over || finalResult(board) == game.result;
+}
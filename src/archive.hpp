@@ -0,0 +1,166 @@
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include "board.hpp"
+
+// On-disk layout of a game archive. The file is a header followed by
+// blocks of whole game records; each block starts with the number of games,
+// its payload size and a CRC-32 of the payload. A game record is an
+// archiveGame, the two player names, a packed start position if the game
+// did not start from the standard position, and one byte per disc placed
+// (square index 0-63 on the standard board). Passes are not stored: they
+// are implied wherever the side to move has no legal move. Integers are
+// little-endian.
+struct archiveHeader {
+    char magic[8];          // "OTTOGAME"
+    uint32_t version;
+    uint32_t boardSide;     // 0 for the standard 8x8 board
+};
+
+struct archiveBlock {
+    uint32_t games;
+    uint32_t bytes;         // payload size, not counting this header
+    uint32_t checksum;      // CRC-32 of the payload
+    uint32_t reserved;
+};
+
+struct archiveGame {
+    uint32_t timeControl;   // time limit per move in ms, 0 if unknown
+    int8_t result;          // final black discs minus white discs
+    uint8_t flags;          // see archiveFlags
+    uint8_t moveCount;
+    uint8_t blackLength;    // bytes of the black player's name
+    uint8_t whiteLength;
+    uint8_t reserved[3];
+};
+
+// archiveGame::flags
+enum archiveFlags : uint8_t {
+    // A start position of archiveStartBytes (16 on the standard board)
+    // follows the names: 2 bits per square, square 0 in the low bits of the
+    // first byte (0 empty, 1 black, 2 white)
+    customStart = 1,
+    // White moves first from the start position
+    whiteFirst = 2
+};
+
+const char archiveMagic[8] = {'O', 'T', 'T', 'O', 'G', 'A', 'M', 'E'};
+const uint32_t archiveVersion = 1;
+const int archiveStartBytes = boardSquares / 4;
+
+// CRC-32 (IEEE) of size bytes, continuing from crc
+uint32_t checksum32(const void *data, size_t size, uint32_t crc = 0);
+
+// Black discs minus white discs at the end of a game, empty squares
+// counting for the winner (the convention of archiveGame::result)
+int finalResult(const othelloBoard &board);
+
+// A game to write. Moves are square indices; -1 (a pass) is skipped.
+struct gameRecord {
+    std::string black;
+    std::string white;
+    int result = 0;
+    uint32_t timeControl = 0;
+    // Start position (1 black, -1 white), empty for the standard one
+    std::vector<int> start;
+    int toMove = 1;
+    std::vector<int> moves;
+};
+
+// A game in a mapped archive. The pointers stay valid while the reader is
+// open; nothing is copied.
+struct gameView {
+    const char *black = nullptr;
+    size_t blackLength = 0;
+    const char *white = nullptr;
+    size_t whiteLength = 0;
+    int result = 0;
+    uint32_t timeControl = 0;
+    // Packed start position, or nullptr for the standard one
+    const uint8_t *start = nullptr;
+    int toMove = 1;
+    const uint8_t *moves = nullptr;
+    int moveCount = 0;
+
+    // Sets board (which may be reused across games) to the start position
+    void startPosition(othelloBoard &board) const;
+};
+
+// Writes an archive, one block at a time
+class othelloArchiveWriter {
+    public:
+        othelloArchiveWriter() {}
+        ~othelloArchiveWriter();
+
+        othelloArchiveWriter(const othelloArchiveWriter &) = delete;
+        othelloArchiveWriter &operator=(const othelloArchiveWriter &) = delete;
+
+        bool open(const std::string &fileName);
+        // Returns false if the game does not fit the format (more than 255
+        // moves or names longer than 255 bytes) or the file cannot be
+        // written
+        bool add(const gameRecord &game);
+        // Writes the last block; returns false if any write failed
+        bool close();
+
+        uint64_t games() const;
+
+        // Payload size at which a block is written out
+        static const size_t blockBytes = 1 << 16;
+
+    private:
+        std::ofstream ofs;
+        std::vector<char> block;
+        uint32_t blockGames = 0;
+        uint64_t written = 0;
+
+        bool flush();
+};
+
+// Reads a memory-mapped archive game by game
+class othelloArchiveReader {
+    public:
+        othelloArchiveReader() {}
+        ~othelloArchiveReader();
+
+        othelloArchiveReader(const othelloArchiveReader &) = delete;
+        othelloArchiveReader &operator=(const othelloArchiveReader &) = delete;
+
+        bool open(const std::string &fileName);
+        void close();
+
+        // Advances to the next game. Returns false at the end of the archive
+        // or on a corrupt block, in which case error() is set.
+        bool next(gameView &game);
+
+        // Starts again from the first game
+        void rewind();
+
+        const std::string &error() const;
+
+        // Replays a game on board from its start position, calling visit
+        // (if given) before every move, passes included, with the side to
+        // move and the square (-1 for a pass). Returns false if a move is
+        // illegal or, with checkResult, the final disc difference of a
+        // finished game does not match the result.
+        static bool replay(const gameView &game, othelloBoard &board,
+                std::function<void(const othelloBoard &, int, int)> visit
+                    = nullptr, bool checkResult = true);
+
+    private:
+        const char *data = nullptr;
+        size_t size = 0;
+        void *mapping = nullptr;
+        // Current position: the block being read and the next record
+        size_t blockEnd = 0;
+        size_t offset = 0;
+        uint32_t blockGames = 0;
+        std::string message;
+
+        bool fail(const std::string &message);
+};
+
+#endif // ARCHIVE_HPP
@@ -0,0 +1,290 @@
+// Endgame solving benchmark.
+//
+// Usage: bench.exe [--suite test/endgame.txt] [--max-empties N]
+//                  [--threads N] [--json FILE] [--max-allocs-per-node X]
+//                  [--endgame-cache FILE]
+//
+// Solves every position of the suite to the end of the game, the same way
+// computerMove searches the remainder of the game tree, and checks the final
+// disc difference against the known exact score. Time, nodes and nodes per
+// second are reported per position and in total. Suite files use the
+// one-line position format of --analyze, followed by "; NAME SCORE MOVES"
+// with the exact score for the side to move and, optionally, every move that
+// reaches it. The exit status is non-zero if any score or move is wrong.
+//
+// In a build that counts allocations (make ALLOC_STATS=1), heap allocations
+// per node are reported as well, broken down by call site in the total, and
+// --max-allocs-per-node fails the run if the search allocates more.
+//
+// With --endgame-cache, solved positions are looked up in and added to a
+// persistent endgame cache (see endgame.hpp), created if needed; running
+// the suite a second time then measures the cache rather than the search.
+
+#include <iomanip>
+#include "analysis.hpp"
+
+struct benchPosition {
+    std::string name;
+    analysisTask task;
+    int empties = 0;
+    int expected = 0;
+    // Moves that reach the expected score; empty if not given
+    std::vector<int> bestMoves;
+};
+
+struct benchResult {
+    searchResult search;
+    int score = 0;
+};
+
+/**
+ * @brief 读取残局测试集
+ *
+ * @param fileName 测试集文件
+ * @param maxEmpties 跳过空格数超过该值的局面
+ * @param suite 追加读取的局面
+ * @param error 读取失败时写入错误信息
+ * @return 读取成功时返回 true
+ */
+bool readSuite(const std::string &fileName, int maxEmpties,
+        std::vector<benchPosition> &suite, std::string &error) {
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.good()) {
+        error = fileName + ": file does not exist";
+        return false;
+    }
+
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(ifs, line)) {
+        lineNum++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos
+                || line[line.find_first_not_of(" \t")] == '#') {
+            continue;
+        }
+
+        benchPosition position;
+        size_t semicolon = line.find(';');
+        std::istringstream iss(semicolon == std::string::npos
+                ? "" : line.substr(semicolon + 1));
+        if (!parsePositionLine(line, position.task)
+                || !(iss >> position.name >> position.expected)) {
+            error = fileName + ":" + std::to_string(lineNum)
+                + ": invalid position";
+            return false;
+        }
+        std::string move;
+        while (iss >> move) {
+            position.bestMoves.push_back(squareIndex(move));
+            if (position.bestMoves.back() == -1) {
+                error = fileName + ":" + std::to_string(lineNum)
+                    + ": invalid move " + move;
+                return false;
+            }
+        }
+
+        position.empties = boardSquares - position.task.board.discsOnBoard;
+        if (maxEmpties <= 0 || position.empties <= maxEmpties) {
+            suite.push_back(position);
+        }
+    }
+
+    return true;
+}
+
+double perNode(long long count, long long nodes) {
+    return (double) count / std::max(nodes, 1LL);
+}
+
+void writeJson(std::ostream &os, const std::vector<benchPosition> &suite,
+        const std::vector<benchResult> &results, float time, long long nodes,
+        const allocCounters &allocations) {
+    os << "{" << std::endl << "  \"positions\": [" << std::endl;
+    for (size_t i = 0; i < suite.size(); i++) {
+        const searchResult &search = results[i].search;
+        os << "    {\"name\": \"" << suite[i].name << "\", \"empties\": "
+            << suite[i].empties << ", \"move\": \""
+            << index2string(search.move) << "\", \"score\": "
+            << results[i].score << ", \"expected\": " << suite[i].expected
+            << ", \"nodes\": " << search.nodes << ", \"time\": "
+            << search.time;
+        if (allocStatsEnabled()) {
+            os << ", \"allocations\": " << search.allocations.totalCalls()
+                << ", \"bytes\": " << search.allocations.totalBytes();
+        }
+        os << "}" << (i + 1 < suite.size() ? "," : "") << std::endl;
+    }
+    os << "  ]," << std::endl;
+    if (allocStatsEnabled()) {
+        os << "  \"allocations\": {";
+        for (int site = 0; site < allocCounters::sites; site++) {
+            os << (site > 0 ? ", " : "") << "\""
+                << allocCounters::siteName(site) << "\": {\"calls\": "
+                << allocations.calls[site] << ", \"bytes\": "
+                << allocations.bytes[site] << "}";
+        }
+        os << "}," << std::endl;
+    }
+    os << "  \"time\": " << time << "," << std::endl;
+    os << "  \"nodes\": " << nodes << "," << std::endl;
+    os << "  \"nps\": " << (long long) (nodes / std::max(time, 1e-6f))
+        << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string suiteFile = "../test/endgame.txt", jsonFile, cacheFile;
+    int maxEmpties = 0, threads = 1;
+    double maxAllocsPerNode = -1;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--suite") {
+                suiteFile = value;
+            }
+            else if (arg == "--max-empties") {
+                maxEmpties = std::stoi(value);
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value);
+            }
+            else if (arg == "--json") {
+                jsonFile = value;
+            }
+            else if (arg == "--max-allocs-per-node") {
+                maxAllocsPerNode = std::stod(value);
+            }
+            else if (arg == "--endgame-cache") {
+                cacheFile = value;
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    std::vector<benchPosition> suite;
+    std::string error;
+    if (!readSuite(suiteFile, maxEmpties, suite, error)) {
+        std::cout << error << std::endl;
+        return 1;
+    }
+
+    othelloEndgameCache cache;
+    if (!cacheFile.empty() && !cache.open(cacheFile)) {
+        std::cout << cache.error() << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(12) << "position" << std::right
+        << std::setw(8) << "empties" << std::setw(6) << "move"
+        << std::setw(7) << "score" << std::setw(9) << "expected"
+        << std::setw(11) << "time" << std::setw(13) << "nodes"
+        << std::setw(11) << "nps"
+        << (allocStatsEnabled() ? "  allocs/node" : "") << std::endl;
+
+    std::vector<benchResult> results(suite.size());
+    float totalTime = 0;
+    long long totalNodes = 0;
+    allocCounters totalAllocations;
+    int failures = 0;
+    for (size_t i = 0; i < suite.size(); i++) {
+        othelloPlayer player;
+        player.computer = true;
+        player.threads = threads;
+        player.color = suite[i].task.toMove;
+        player.endgameCache = cache.isOpen() ? &cache : nullptr;
+
+        // Search to the end of the game, as computerMove does in the endgame
+        searchLimits limits;
+        limits.depth = suite[i].empties;
+        othelloBoard board = suite[i].task.board;
+        results[i].search = player.analyze(board, limits);
+        results[i].score = othelloHeuristic::discScore(results[i].search.score);
+
+        const searchResult &search = results[i].search;
+        const std::vector<int> &bestMoves = suite[i].bestMoves;
+        bool ok = (results[i].score == suite[i].expected)
+            && (bestMoves.empty() || std::find(bestMoves.begin(),
+                        bestMoves.end(), search.move) != bestMoves.end());
+        failures += ok ? 0 : 1;
+        totalTime += search.time;
+        totalNodes += search.nodes;
+        totalAllocations += search.allocations;
+
+        std::cout << std::left << std::setw(12) << suite[i].name << std::right
+            << std::setw(8) << suite[i].empties
+            << std::setw(6) << index2string(search.move)
+            << std::setw(7) << results[i].score
+            << std::setw(9) << suite[i].expected
+            << std::setw(10) << search.time << "s"
+            << std::setw(13) << search.nodes
+            << std::setw(11)
+            << (long long) (search.nodes / std::max(search.time, 1e-6f));
+        if (allocStatsEnabled()) {
+            std::cout << std::setw(13)
+                << perNode(search.allocations.totalCalls(), search.nodes);
+        }
+        std::cout << (ok ? "" : "  FAIL") << std::endl;
+    }
+
+    std::cout << "Total: " << suite.size() << " positions, " << failures
+        << " wrong, " << totalTime << "s, " << totalNodes << " nodes, "
+        << (long long) (totalNodes / std::max(totalTime, 1e-6f)) << " nps"
+        << std::endl;
+
+    if (allocStatsEnabled()) {
+        std::cout << "Allocations: " << totalAllocations.totalCalls() << " ("
+            << perNode(totalAllocations.totalCalls(), totalNodes)
+            << " per node), " << totalAllocations.totalBytes() << " bytes ("
+            << perNode(totalAllocations.totalBytes(), totalNodes)
+            << " per node)" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+        for (int site = 0; site < allocCounters::sites; site++) {
+            std::cout << "  " << std::left << std::setw(16)
+                << allocCounters::siteName(site) << std::right
+                << std::setw(14) << totalAllocations.calls[site]
+                << std::setw(10)
+                << perNode(totalAllocations.calls[site], totalNodes)
+                << " per node" << std::setw(16)
+                << totalAllocations.bytes[site] << " bytes" << std::endl;
+        }
+
+        double allocsPerNode = perNode(totalAllocations.totalCalls(),
+                totalNodes);
+        if (maxAllocsPerNode >= 0 && allocsPerNode > maxAllocsPerNode) {
+            std::cout << "FAIL: " << allocsPerNode
+                << " allocations per node, limit " << maxAllocsPerNode
+                << std::endl;
+            failures++;
+        }
+    }
+    else if (maxAllocsPerNode >= 0) {
+        std::cout << "--max-allocs-per-node needs a build with ALLOC_STATS=1"
+            << std::endl;
+        return 1;
+    }
+
+    if (!jsonFile.empty()) {
+        std::ofstream ofs(jsonFile.c_str());
+        if (!ofs.good()) {
+            std::cout << "Could not write " << jsonFile << std::endl;
+            return 1;
+        }
+        writeJson(ofs, suite, results, totalTime, totalNodes,
+                totalAllocations);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -5,15 +5,33 @@
  * @brief 构造函数
  *
  * 初始化棋盘，将棋盘上的每个位置初始化为0。
- * positions是一个大小为64的数组，每个元素初始化为0。
+ * positions是一个大小为boardSquares的数组，每个元素初始化为0。
  */
 othelloBoard::othelloBoard() {
     // 初始化棋盘，将棋盘上的每个位置初始化为0
-    // positions是一个大小为64的数组，每个元素初始化为0
-    this->positions.resize(64, 0);
+    // positions是一个大小为boardSquares的数组，每个元素初始化为0
+    this->positions.resize(boardSquares, 0);
     // positions数组初始化完毕
 }
 
+// Set up the start position
+/**
+ * @brief 摆出开局局面
+ *
+ * 清空棋盘，在中央四格放上双方各两枚棋子，白子位于左上到右下的对角线。
+ */
+void othelloBoard::startPosition() {
+    this->positions.assign(boardSquares, 0);
+    for (int i = 0; i < 2; i++) {
+        this->positions[geometry::whiteStart[i]] = -1;
+        this->positions[geometry::blackStart[i]] = 1;
+    }
+    this->discsOnBoard = 4;
+    this->passes[0] = false;
+    this->passes[1] = false;
+    this->moves.clear();
+}
+
 // Display board: color is 1 for black, -1 for white
 /**
  * @brief 显示棋盘
@@ -24,17 +42,22 @@ othelloBoard::othelloBoard() {
  */
 void othelloBoard::displayBoard(int color) {
     // 打印棋盘标题
-    std::cout << "    A B C D E F G H" << std::endl;
+    std::cout << "   ";
+    for (int col = 0; col < boardSide; col++) {
+        std::cout << " " << (char) ('A' + col);
+    }
+    std::cout << std::endl;
 
     int row = 1;
-    for (int i = 0; i < 64; i += 8) {
+    for (int i = 0; i < boardSquares; i += boardSide) {
         // 打印棋盘行号
         // Green space
-        std::cout << " " << row++ << " "
+        std::cout << (row < 10 ? " " : "") << row << " "
             << "\033[48;5;34m\033[38;5;232m \033[0m"; // 打印绿色空格
+        row++;
 
         // 遍历当前行的每一个格子
-        for (int j = i; j < i+8; j++) {
+        for (int j = i; j < i + boardSide; j++) {
             // 检查当前位置是否有棋子
             if (this->positions[j] == 1) {
                 // 打印黑色棋子
@@ -66,11 +89,11 @@ void othelloBoard::displayBoard(int color) {
         }
 
         // 在棋盘底部打印双方棋子数量
-        if (i == 24) {
+        if (i == geometry::square(boardSide/2 - 1, 0)) {
             std::cout << "\t\tBlack: " << std::count(this->positions.begin(),
                     this->positions.end(), 1); // 打印黑色棋子数量
         }
-        else if (i == 32) {
+        else if (i == geometry::square(boardSide/2, 0)) {
             std::cout << "\t\tWhite: " << std::count(this->positions.begin(),
                     this->positions.end(), -1); // 打印白色棋子数量
         }
@@ -91,10 +114,6 @@ void othelloBoard::displayBoard(int color) {
  */
 void othelloBoard::displayLegalMoves() {
     // 定义列和行的坐标字符串
-    std::string colCoord = "ABCDEFGH";
-    std::string rowCoord = "12345678";
-
-    int colNum = 0, rowNum = 0; // 列和行的索引变量
     int moveNum = 1; // 合法移动的编号
     std::list<int> flippedDiscs; // 记录翻转的棋子
 
@@ -103,8 +122,7 @@ void othelloBoard::displayLegalMoves() {
     // 遍历moves中的所有移动
     for (auto keyval : this->moves) {
         // 将索引转换为坐标
-        index2coord(keyval.first, colNum, rowNum);
-        std::cout << "\t" << moveNum++ << "\t" << colCoord[colNum] << rowCoord[rowNum];
+        std::cout << "\t" << moveNum++ << "\t" << squareName(keyval.first);
 
         // 获取当前移动翻转的棋子列表
         flippedDiscs = keyval.second;
@@ -113,8 +131,7 @@ void othelloBoard::displayLegalMoves() {
         // 遍历翻转的棋子列表
         for (int disc : flippedDiscs) {
             // 将索引转换为坐标
-            index2coord(disc, colNum, rowNum);
-            std::cout << colCoord[colNum] << rowCoord[rowNum] << " ";
+            std::cout << squareName(disc) << " ";
         }
 
         std::cout << std::endl;
@@ -123,40 +140,71 @@ void othelloBoard::displayLegalMoves() {
     std::cout << std::endl;
 }
 
+namespace {
+    // rays.length[i][d] is the number of squares between square i and the
+    // edge of the board in direction geometry::directions[d], so that a
+    // scan never wraps around to the next row
+    struct rayTable {
+        int length[boardSquares][8];
+    };
+
+    constexpr rayTable makeRays() {
+        rayTable rays = {};
+        for (int i = 0; i < boardSquares; i++) {
+            int row = geometry::row(i), col = geometry::col(i);
+            int up = row, down = boardSide - 1 - row, left = col,
+                right = boardSide - 1 - col;
+            rays.length[i][0] = left;
+            rays.length[i][1] = right;
+            rays.length[i][2] = up;
+            rays.length[i][3] = down;
+            rays.length[i][4] = (up < left) ? up : left;
+            rays.length[i][5] = (down < right) ? down : right;
+            rays.length[i][6] = (up < right) ? up : right;
+            rays.length[i][7] = (down < left) ? down : left;
+        }
+        return rays;
+    }
+
+    constexpr rayTable rays = makeRays();
+}
+
 // Finds all legal moves, writing to a reference to a hash table with
 // legal moves as keys, and a list of all discs to be flipped as values.
 /**
  * @brief 查找当前玩家可以下的合法走法
  *
- * 为给定颜色的玩家查找并返回所有可能的合法走法。
+ * 为给定颜色的玩家查找并返回所有可能的合法走法。按颜色分派到编译期实例化的
+ * 版本，内层循环中不再判断颜色。
  *
  * @param color 当前玩家的颜色
  * @param pMoves 用于存储合法走法的指针，键为棋盘位置，值为可能的走法列表
  */
 void othelloBoard::findLegalMoves(int color,
         std::unordered_map<int, std::list<int>> *pMoves) {
+    if (color == 1) {
+        this->findLegalMoves<1>(pMoves);
+    }
+    else {
+        this->findLegalMoves<-1>(pMoves);
+    }
+}
+
+template <int color>
+void othelloBoard::findLegalMoves(
+        std::unordered_map<int, std::list<int>> *pMoves) {
     // 清除上一手棋的合法走法
     // Clear legal moves from previous ply
     this->moves.clear();
 
-    for (int i = 0; i < 64; i++) {
+    for (int i = 0; i < boardSquares; i++) {
         if (this->positions[i] == color) {
-            // 检查行
-            // Check rows
-            findLegalMoveInDirection(i, color, -1, pMoves);
-            findLegalMoveInDirection(i, color, 1, pMoves);
-
-            // 检查列
-            // Check columns
-            findLegalMoveInDirection(i, color, -8, pMoves);
-            findLegalMoveInDirection(i, color, 8, pMoves);
-
-            // 检查对角线
-            // Check diagonals
-            findLegalMoveInDirection(i, color, -9, pMoves);
-            findLegalMoveInDirection(i, color, 9, pMoves);
-            findLegalMoveInDirection(i, color, -7, pMoves);
-            findLegalMoveInDirection(i, color, 7, pMoves);
+            // 依次检查行、列与对角线
+            // Check rows, columns and diagonals
+            for (int d = 0; d < 8; d++) {
+                findLegalMoveInDirection<color>(i, geometry::directions[d],
+                        rays.length[i][d], pMoves);
+            }
         }
     }
 }
@@ -168,54 +216,35 @@ void othelloBoard::findLegalMoves(int color,
  * @brief 在给定方向上查找合法的移动
  *
  * 在指定的方向上查找所有合法的移动，并记录这些移动可以翻转的棋子列表。
+ * 扫描的步数由到棋盘边缘的距离表给出，因此不会越过边缘绕到下一行。
  *
+ * @tparam color 当前棋子的颜色，1 为黑方，-1 为白方
  * @param disc 当前棋子的索引
- * @param color 当前棋子的颜色（非零值，正数代表白方，负数代表黑方）
  * @param direction 移动方向（正数或负数，表示向上、向下、向左或向右移动）
+ * @param length 该方向上到棋盘边缘的格数
  * @param pMoves 指向存储合法移动和翻转棋子列表的哈希表的指针
  */
-void othelloBoard::findLegalMoveInDirection(int &disc, int &color, int direction,
-        std::unordered_map<int, std::list<int>> *pMoves) {
-    // 初始化一个合法的移动和翻转的棋子列表
-    std::pair<int, std::list<int>> legalMove;
+template <int color>
+void othelloBoard::findLegalMoveInDirection(int disc, int direction,
+        int length, std::unordered_map<int, std::list<int>> *pMoves) {
     std::list<int> flippedDiscs;
-    // 当前棋格位置初始化为0
-    int currentSquare = 0;
-    // 用于转换棋格索引到行列的临时变量
-    int row1 = 0, col1 = 0, row2 = 0, col2 = 0;
-
-    // 沿给定方向遍历棋格
-    for (int i = disc + direction; i < 64 && i > -1; i += direction) {
-        // 防止棋盘边缘的棋格越界
-        // Guard against wrapping around the board
-        index2coord(i-direction, col1, row1);
-        index2coord(i, col2, row2);
-        // 如果当前棋格和前一个棋格的行或列变化超过1，则跳出循环
-        if (abs(col1 - col2) > 1 || abs(row1 - row2) > 1) {
-            break;
-        }
 
+    // 沿给定方向遍历棋格，直到棋盘边缘
+    for (int i = disc + direction; length > 0; i += direction, length--) {
         // 沿给定方向继续移动，记住任何相反颜色的棋子。如果遇到相同颜色的棋子则跳出循环
         // Keep moving in given direction, remembering any discs of the
         // opposite color. Break if we see any discs of our color.
-        currentSquare = this->positions[i];
-        if (currentSquare == color ||
-                (currentSquare == 0 && flippedDiscs.empty())) {
-            break;
-        }
-        // 如果遇到相反颜色的棋子，则记录其位置
-        else if (currentSquare == -color) {
+        int currentSquare = this->positions[i];
+        if (currentSquare == -color) {
             flippedDiscs.push_front(i);
             continue;
         }
         // 如果遇到一个空棋格，并且已经记录了翻转的棋子，则此位置是一个合法的移动
         // 插入到哈希表中，但需要先检查是否已经存在该移动
-        // If we see an empty square, it is a legal move: insert it into the
-        // moves hash table.
+        // If we see an empty square after discs of the opposite color, it
+        // is a legal move: insert it into the moves hash table.
         // NB: we must check to see if the move is already in the map.
-        // Second condition is to resolve edge case of
-        // disc immediately adjacent to original disc.
-        else if (currentSquare == 0 && !flippedDiscs.empty()) {
+        if (currentSquare == 0 && !flippedDiscs.empty()) {
             std::unordered_map<int, std::list<int>>::iterator it = pMoves->find(i);
 
             // 如果该移动已经存在，则合并翻转的棋子列表
@@ -224,14 +253,12 @@ void othelloBoard::findLegalMoveInDirection(int &disc, int &color, int direction
             }
             // 否则，插入新的合法移动和翻转的棋子列表
             else {
-                legalMove.first = i;
-                legalMove.second = flippedDiscs;
-                pMoves->insert(legalMove);
+                pMoves->emplace(i, std::move(flippedDiscs));
             }
-
-            // 跳出循环
-            break;
         }
+
+        // 遇到己方棋子、空格或已找到走法，则停止
+        break;
     }
 }
 
@@ -246,22 +273,35 @@ void othelloBoard::findLegalMoveInDirection(int &disc, int &color, int direction
  *             - move.first 表示移动的位置
  *             - move.second 表示翻转的棋子列表
  */
-void othelloBoard::updateBoard(int color, std::pair<int, std::list<int>> move) {
-    // 获取移动的位置
-    int square = move.first;
-    // 获取翻转的棋子列表
-    std::list<int> flippedDiscs = move.second;
-
-    // 将移动位置设置为当前玩家颜色
-    this->positions[square] = color;
+void othelloBoard::updateBoard(int color,
+        const std::pair<const int, std::list<int>> &move) {
+    if (color == 1) {
+        this->updateBoard<1>(move);
+    }
+    else {
+        this->updateBoard<-1>(move);
+    }
+}
 
-    // 遍历翻转的棋子列表
-    for (auto disc : flippedDiscs) {
-        // 将翻转的棋子位置设置为当前玩家颜色
+template <int color>
+void othelloBoard::updateBoard(
+        const std::pair<const int, std::list<int>> &move) {
+    // 将移动位置与翻转的棋子设置为当前玩家颜色
+    this->positions[move.first] = color;
+    for (int disc : move.second) {
         this->positions[disc] = color;
     }
 }
 
+template void othelloBoard::findLegalMoves<1>(
+        std::unordered_map<int, std::list<int>> *);
+template void othelloBoard::findLegalMoves<-1>(
+        std::unordered_map<int, std::list<int>> *);
+template void othelloBoard::updateBoard<1>(
+        const std::pair<const int, std::list<int>> &);
+template void othelloBoard::updateBoard<-1>(
+        const std::pair<const int, std::list<int>> &);
+
 // Checks if game is a terminal state
 /**
  * @brief 判断棋盘是否到达终局状态
@@ -286,15 +326,15 @@ bool othelloBoard::terminalState() {
  *
  * 将给定的索引值转换为对应的列号和行号。
  *
- * @param index 给定的索引值，索引值范围从0到63。
- * @param colNum 用于存储转换后的列号，范围从0到7。
- * @param rowNum 用于存储转换后的行号，范围从0到7。
+ * @param index 给定的索引值，索引值范围从0到boardSquares-1。
+ * @param colNum 用于存储转换后的列号，范围从0到boardSide-1。
+ * @param rowNum 用于存储转换后的行号，范围从0到boardSide-1。
  */
 void othelloBoard::index2coord(int index, int &colNum, int &rowNum) {
-    // 将index除以8取余数得到列号
+    // 将index除以边长取余数得到列号
     // 计算列号
-    colNum = index % 8;
-    // 将index除以8取整得到行号
+    colNum = geometry::col(index);
+    // 将index除以边长取整得到行号
     // 计算行号
-    rowNum = index / 8;
+    rowNum = geometry::row(index);
 }
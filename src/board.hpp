@@ -7,12 +7,14 @@
 #include <list>
 #include <tuple>
 #include <algorithm>
+#include "geometry.hpp"
 
 class othelloBoard {
     public:
         // positions specifies all pieces on the board. Squares on the
-        // board are indexed from 0 to 63, left to right, top to bottom.
-        // positions[i] is 1 for a black disc, -1 for a white disc
+        // board are indexed from 0 to boardSquares - 1 (63 on the standard
+        // board), left to right, top to bottom. positions[i] is 1 for a
+        // black disc, -1 for a white disc
         std::vector<int> positions;
 
         int discsOnBoard = 4;
@@ -30,6 +32,9 @@ class othelloBoard {
         // Constructor
         othelloBoard();
 
+        // Clears the board and sets up the four centre discs
+        void startPosition();
+
         // Display board
         void displayBoard(int color);
 
@@ -40,15 +45,24 @@ class othelloBoard {
         // legal moves as keys, and a list of all discs to be flipped as values.
         void findLegalMoves(int color,
                 std::unordered_map<int, std::list<int>> *pMoves);
+        // The same for a color fixed at compile time (1 or -1), which the
+        // search and the heuristic use
+        template <int color>
+        void findLegalMoves(std::unordered_map<int, std::list<int>> *pMoves);
 
         // Helper function to find a legal move given a disc, its color and a direction.
         // Writes the legal move and a list of all discs to be flipped as a pair to the
-        // reference to a hash table.
-        void findLegalMoveInDirection(int &disc, int &color, int direction,
+        // reference to a hash table. length is the number of squares between
+        // the disc and the edge of the board in that direction.
+        template <int color>
+        void findLegalMoveInDirection(int disc, int direction, int length,
                 std::unordered_map<int, std::list<int>> *pMoves);
 
         // Update board after a move
-        void updateBoard(int color, std::pair<int, std::list<int>> move);
+        void updateBoard(int color,
+                const std::pair<const int, std::list<int>> &move);
+        template <int color>
+        void updateBoard(const std::pair<const int, std::list<int>> &move);
 
         bool terminalState();
 
@@ -0,0 +1,412 @@
+// Extends the opening book by drop-out expansion.
+//
+// Usage: bookbuild.exe [--catalogue lib/openings.dat] [--out lib/openings.bin]
+//                      [--depth 6] [--expansions 1000] [--threads N]
+//                      [--batch N] [--dropout 1000] [--max-ply 24]
+//                      [--checkpoint 100]
+//
+// The tree is seeded with every line of the catalogue. Each round picks the
+// most promising unexpanded positions, i.e. those with the smallest drop-out
+// cost: the sum along the path of how much worse each move is than the best
+// move at its parent, plus a fixed penalty per ply. Their children are
+// searched to a fixed depth on a thread pool and the negamax values are
+// backed up to the root. The book is written every --checkpoint expansions
+// and at the end, mapping every expanded position to its best move.
+
+#include <cstdio>
+#include <memory>
+#include "player.hpp"
+#include "threadpool.hpp"
+
+struct bookNode {
+    std::string history;
+    std::vector<int> positions;
+    int toMove = 1;
+    int discs = 4;
+    int move = -1;
+    int parent = -1;
+    std::vector<int> children;
+    // Negamax value from the point of view of the side to move
+    int value = 0;
+    bool expanded = false;
+    // Side to move has no legal move; such positions are never expanded
+    bool blocked = false;
+};
+
+class bookBuilder {
+    public:
+        int depth = 6;
+        int dropout = 1000;
+        int maxPly = 24;
+
+        explicit bookBuilder(int numThreads) : pool(numThreads) {
+            for (int i = 0; i < numThreads; i++) {
+                this->players.emplace_back(new othelloPlayer());
+                this->players.back()->computer = true;
+            }
+
+            bookNode root;
+            othelloBoard start;
+            start.startPosition();
+            root.positions = start.positions;
+            this->tree.push_back(root);
+        }
+
+        bool seed(const std::string &fileName);
+        int expand(int batch);
+        void backup(int index);
+        bool write(const std::string &fileName);
+
+        size_t expandedCount() const {
+            size_t count = 0;
+            for (const bookNode &node : this->tree) {
+                count += node.expanded;
+            }
+            return count;
+        }
+
+    private:
+        std::vector<bookNode> tree;
+        std::vector<std::unique_ptr<othelloPlayer>> players;
+        othelloThreadPool pool;
+
+        void makeBoard(const bookNode &node, othelloBoard &board);
+        void generateChildren(int index, std::vector<int> &fresh);
+        void evaluate(int index, othelloPlayer &player);
+        void collectLeaves(int index, long long cost, int ply,
+                std::vector<std::pair<long long, int>> &leaves);
+};
+
+void bookBuilder::makeBoard(const bookNode &node, othelloBoard &board) {
+    board.positions = node.positions;
+    board.discsOnBoard = node.discs;
+    board.moves.clear();
+}
+
+/**
+ * @brief 生成节点的全部子节点
+ *
+ * @param index 待展开的节点下标
+ * @param fresh 新生成且需要评估的子节点下标
+ */
+void bookBuilder::generateChildren(int index, std::vector<int> &fresh) {
+    othelloBoard board;
+    this->makeBoard(this->tree[index], board);
+    board.findLegalMoves(this->tree[index].toMove, &board.moves);
+
+    for (auto keyval : board.moves) {
+        bookNode child;
+        othelloBoard next = board;
+        next.updateBoard(this->tree[index].toMove, keyval);
+
+        child.history = this->tree[index].history
+            + std::to_string(keyval.first) + ",";
+        child.positions = next.positions;
+        child.toMove = -this->tree[index].toMove;
+        child.discs = this->tree[index].discs + 1;
+        child.move = keyval.first;
+        child.parent = index;
+
+        next.findLegalMoves(child.toMove, &next.moves);
+        child.blocked = next.moves.empty();
+
+        this->tree.push_back(child);
+        this->tree[index].children.push_back(this->tree.size() - 1);
+        fresh.push_back(this->tree.size() - 1);
+    }
+
+    this->tree[index].expanded = true;
+}
+
+/**
+ * @brief 用固定深度搜索评估叶节点
+ *
+ * 轮到的一方无子可下时，从对手角度搜索并取反；双方都无子可下时按子数差计分。
+ *
+ * @param index 叶节点下标
+ * @param player 当前工作线程独占的搜索器
+ */
+void bookBuilder::evaluate(int index, othelloPlayer &player) {
+    bookNode &node = this->tree[index];
+    othelloBoard board;
+    this->makeBoard(node, board);
+
+    searchLimits limits;
+    limits.depth = this->depth;
+
+    player.color = node.toMove;
+    searchResult result = player.analyze(board, limits);
+    if (result.move != -1) {
+        node.value = result.score;
+        return;
+    }
+
+    player.color = -node.toMove;
+    result = player.analyze(board, limits);
+    if (result.move != -1) {
+        node.value = -result.score;
+        return;
+    }
+
+    int discDifference = std::accumulate(node.positions.begin(),
+            node.positions.end(), 0);
+    node.value = 100000*discDifference*node.toMove;
+}
+
+// Recomputes negamax values from index up to the root
+void bookBuilder::backup(int index) {
+    while (index != -1) {
+        bookNode &node = this->tree[index];
+        if (node.expanded && !node.children.empty()) {
+            node.value = INT_MIN;
+            for (int child : node.children) {
+                node.value = std::max(node.value, -this->tree[child].value);
+            }
+        }
+        index = node.parent;
+    }
+}
+
+/**
+ * @brief 沿目录中的每一条开局线展开树
+ *
+ * @param fileName 开局目录文件（lib/openings.dat 格式）
+ * @return 读取成功时返回 true
+ */
+bool bookBuilder::seed(const std::string &fileName) {
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.good()) {
+        std::cout << "File does not exist!" << std::endl;
+        return false;
+    }
+
+    std::string line, sequence;
+    std::vector<int> squares, fresh;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        if (!(iss >> sequence)
+                || !othelloDatabase::parseCatalogueLine(sequence, squares)) {
+            continue;
+        }
+
+        int index = 0;
+        for (int square : squares) {
+            if (!this->tree[index].expanded) {
+                this->generateChildren(index, fresh);
+            }
+
+            int next = -1;
+            for (int child : this->tree[index].children) {
+                if (this->tree[child].move == square) {
+                    next = child;
+                }
+            }
+            if (next == -1 || this->tree[next].blocked) {
+                break;
+            }
+            index = next;
+        }
+    }
+
+    for (int index : fresh) {
+        this->pool.submit([this, index](int worker) {
+            this->evaluate(index, *this->players[worker]);
+        });
+    }
+    this->pool.wait();
+
+    for (int index : fresh) {
+        this->backup(index);
+    }
+
+    std::cout << "Seeded " << this->expandedCount() << " positions from "
+        << fileName << std::endl;
+    return true;
+}
+
+// Collects unexpanded leaves together with their drop-out cost
+void bookBuilder::collectLeaves(int index, long long cost, int ply,
+        std::vector<std::pair<long long, int>> &leaves) {
+    const bookNode &node = this->tree[index];
+    if (!node.expanded) {
+        if (!node.blocked && ply < this->maxPly) {
+            leaves.push_back({cost, index});
+        }
+        return;
+    }
+
+    for (int child : node.children) {
+        long long drop = (long long) node.value + this->tree[child].value;
+        this->collectLeaves(child, cost + drop + this->dropout, ply + 1,
+                leaves);
+    }
+}
+
+/**
+ * @brief 执行一轮展开
+ *
+ * 选取代价最小的 batch 个叶节点，生成其子节点并在线程池上并行评估，
+ * 最后回溯更新负极大值。
+ *
+ * @param batch 本轮展开的叶节点数
+ * @return 实际展开的节点数，为 0 时表示树已无法继续展开
+ */
+int bookBuilder::expand(int batch) {
+    std::vector<std::pair<long long, int>> leaves;
+    this->collectLeaves(0, 0, 0, leaves);
+
+    if ((int) leaves.size() > batch) {
+        std::partial_sort(leaves.begin(), leaves.begin() + batch,
+                leaves.end());
+        leaves.resize(batch);
+    }
+
+    std::vector<int> fresh;
+    for (auto leaf : leaves) {
+        this->generateChildren(leaf.second, fresh);
+    }
+
+    for (int index : fresh) {
+        this->pool.submit([this, index](int worker) {
+            this->evaluate(index, *this->players[worker]);
+        });
+    }
+    this->pool.wait();
+
+    for (auto leaf : leaves) {
+        this->backup(leaf.second);
+    }
+
+    return leaves.size();
+}
+
+/**
+ * @brief 写出开局库
+ *
+ * 每个已展开的节点记录其最佳子节点。先写入临时文件再重命名，
+ * 因此检查点在任何时刻都是完整的。
+ *
+ * @param fileName 输出文件名
+ * @return 写出成功时返回 true
+ */
+bool bookBuilder::write(const std::string &fileName) {
+    std::vector<bookEntry> book;
+    for (const bookNode &node : this->tree) {
+        if (!node.expanded || node.children.empty()) {
+            continue;
+        }
+
+        const bookNode *best = nullptr;
+        for (int child : node.children) {
+            if (best == nullptr || -this->tree[child].value > -best->value) {
+                best = &this->tree[child];
+            }
+        }
+
+        bookEntry entry = {};
+        entry.key = othelloDatabase::hashHistory(node.history);
+        entry.move = best->move;
+        entry.score = node.value;
+        book.push_back(entry);
+    }
+
+    std::string tmpName = fileName + ".tmp";
+    if (!othelloDatabase::writeBook(tmpName, book)) {
+        return false;
+    }
+    return std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+int main(int argc, char **argv) {
+    std::string catalogue = "../lib/openings.dat";
+    std::string output = "../lib/openings.bin";
+    int depth = 6, expansions = 1000, dropout = 1000, maxPly = 24;
+    int checkpoint = 100;
+    int numThreads = std::thread::hardware_concurrency();
+    int batch = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cout << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--catalogue") {
+            catalogue = value;
+        }
+        else if (arg == "--out") {
+            output = value;
+        }
+        else if (arg == "--depth") {
+            depth = std::stoi(value);
+        }
+        else if (arg == "--expansions") {
+            expansions = std::stoi(value);
+        }
+        else if (arg == "--threads") {
+            numThreads = std::stoi(value);
+        }
+        else if (arg == "--batch") {
+            batch = std::stoi(value);
+        }
+        else if (arg == "--dropout") {
+            dropout = std::stoi(value);
+        }
+        else if (arg == "--max-ply") {
+            maxPly = std::stoi(value);
+        }
+        else if (arg == "--checkpoint") {
+            checkpoint = std::stoi(value);
+        }
+        else {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    if (batch < 1) {
+        batch = numThreads;
+    }
+
+    bookBuilder builder(numThreads);
+    builder.depth = depth;
+    builder.dropout = dropout;
+    builder.maxPly = maxPly;
+
+    if (!builder.seed(catalogue)) {
+        return 1;
+    }
+
+    int done = 0, sinceCheckpoint = 0;
+    while (done < expansions) {
+        int expanded = builder.expand(std::min(batch, expansions - done));
+        if (expanded == 0) {
+            break;
+        }
+        done += expanded;
+        sinceCheckpoint += expanded;
+
+        if (checkpoint > 0 && sinceCheckpoint >= checkpoint) {
+            sinceCheckpoint = 0;
+            if (!builder.write(output)) {
+                std::cout << "Could not write " << output << std::endl;
+                return 1;
+            }
+            std::cout << "Checkpoint: " << done << " expansions, "
+                << builder.expandedCount() << " positions" << std::endl;
+        }
+    }
+
+    if (!builder.write(output)) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << builder.expandedCount() << " positions to "
+        << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Compiles an opening catalogue into the binary book read by othelloDatabase.
+//
+// Usage: compilebook.exe <input> <output>
+//
+// The input is either the catalogue lib/openings.dat ("C4c3D3c5B3  Name") or
+// the older lib/openings.txt, with alternating move history and next move
+// lines. The output is a bookHeader followed by bookEntry records sorted by
+// key. When a history appears more than once, the first entry wins.
+
+#include <cstring>
+#include <sstream>
+#include "database.hpp"
+
+/**
+ * @brief 读取开局目录或旧版文本开局库
+ *
+ * @param fileName 输入文件名（.dat 或 .txt）
+ * @param book 输出的开局库条目，按文件顺序排列
+ * @return 读取成功时返回 true
+ */
+bool readOpenings(const std::string &fileName, std::vector<bookEntry> &book) {
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.good()) {
+        std::cout << "File does not exist!" << std::endl;
+        return false;
+    }
+
+    bool catalogue = fileName.size() >= 4
+        && fileName.compare(fileName.size() - 4, 4, ".dat") == 0;
+
+    std::string line, pastMoves, nextMove;
+    std::vector<int> squares;
+    bookEntry entry = {};
+
+    if (catalogue) {
+        while (std::getline(ifs, line)) {
+            std::istringstream iss(line);
+            std::string sequence;
+            if (!(iss >> sequence)) {
+                continue;
+            }
+            if (!othelloDatabase::parseCatalogueLine(sequence, squares)) {
+                std::cout << "Invalid catalogue line: " << line << std::endl;
+                return false;
+            }
+
+            pastMoves.clear();
+            for (size_t i = 0; i + 1 < squares.size(); i++) {
+                pastMoves.append(std::to_string(squares[i]) + ",");
+            }
+            entry.key = othelloDatabase::hashHistory(pastMoves);
+            entry.move = squares.back();
+            book.push_back(entry);
+        }
+    }
+    else {
+        while (std::getline(ifs, pastMoves) && std::getline(ifs, nextMove)) {
+            entry.key = othelloDatabase::hashHistory(pastMoves);
+            entry.move = std::stoi(nextMove);
+            book.push_back(entry);
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <openings.dat|openings.txt> <book.bin>"
+            << std::endl;
+        return 1;
+    }
+
+    std::vector<bookEntry> book;
+    if (!readOpenings(argv[1], book)) {
+        return 1;
+    }
+
+    if (!othelloDatabase::writeBook(argv[2], book)) {
+        std::cout << "Could not write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << book.size() << " positions to " << argv[2]
+        << std::endl;
+    return 0;
+}
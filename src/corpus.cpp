@@ -0,0 +1,251 @@
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "corpus.hpp"
+
+corpusRecord corpusRecord::fromBoard(const othelloBoard &board, int toMove) {
+    corpusRecord record = {};
+    for (int i = 0; i < corpusSquares; i++) {
+        if (board.positions[i] == 1) {
+            record.black |= 1ULL << i;
+        }
+        else if (board.positions[i] == -1) {
+            record.white |= 1ULL << i;
+        }
+    }
+    record.toMove = toMove;
+    record.move = -1;
+    return record;
+}
+
+/**
+ * @brief 将记录还原为棋盘
+ *
+ * 只改写 positions 中的值，不重新分配，因此同一个棋盘可以反复使用。
+ *
+ * @param board 写入棋盘布局与棋子数
+ */
+void corpusRecord::toBoard(othelloBoard &board) const {
+    board.positions.assign(boardSquares, 0);
+    for (int i = 0; i < corpusSquares; i++) {
+        board.positions[i] = ((this->black >> i) & 1) ? 1
+            : ((this->white >> i) & 1) ? -1 : 0;
+    }
+    board.discsOnBoard = __builtin_popcountll(this->black | this->white);
+    board.moves.clear();
+    board.passes[0] = false;
+    board.passes[1] = false;
+}
+
+bool isCorpusFile(const std::string &fileName) {
+    std::ifstream ifs(fileName.c_str(), std::ios::binary);
+    char magic[sizeof(corpusMagic)] = {};
+    ifs.read(magic, sizeof(magic));
+    return ifs.good() && std::memcmp(magic, corpusMagic, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief 解析文本局面的标签
+ *
+ * @param text 分号之后的文本，例如 "12 exact"、"-350 d8 C4"
+ * @param record 写入分数、深度、走法与标志
+ * @return 含有分数时返回 true
+ */
+bool parseCorpusLabel(const std::string &text, corpusRecord &record) {
+    std::istringstream iss(text);
+    std::string token;
+    if (!(iss >> token)) {
+        return false;
+    }
+    try {
+        size_t used = 0;
+        record.score = std::stoi(token, &used);
+        if (used != token.length()) {
+            return false;
+        }
+    }
+    catch (const std::exception &) {
+        return false;
+    }
+    record.flags |= hasScore;
+
+    while (iss >> token) {
+        if (token == "exact") {
+            record.flags |= exactScore;
+        }
+        else if (token.length() > 1 && token[0] == 'd'
+                && std::isdigit((unsigned char) token[1])) {
+            record.depth = std::min(std::atoi(token.c_str() + 1), 255);
+        }
+        else if (squareIndex(token) >= 0) {
+            record.move = squareIndex(token);
+            record.flags |= hasMove;
+        }
+    }
+    return true;
+}
+
+std::string corpusLabel(const corpusRecord &record) {
+    std::string label;
+    if (record.flags & hasScore) {
+        label = std::to_string(record.score);
+        if (record.flags & exactScore) {
+            label += " exact";
+        }
+        else if (record.depth > 0) {
+            label += " d" + std::to_string(record.depth);
+        }
+    }
+    if (record.flags & hasMove) {
+        label += (label.empty() ? "" : " ");
+        label += squareName(record.move);
+    }
+    return label;
+}
+
+std::string corpusLine(const corpusRecord &record) {
+    std::string line;
+    for (int i = 0; i < corpusSquares; i++) {
+        line += ((record.black >> i) & 1) ? 'X'
+            : ((record.white >> i) & 1) ? 'O' : '-';
+    }
+    line += (record.toMove == 1) ? " X" : " O";
+    std::string label = corpusLabel(record);
+    if (!label.empty()) {
+        line += " ; " + label;
+    }
+    return line;
+}
+
+othelloCorpusWriter::~othelloCorpusWriter() {
+    if (this->ofs.is_open()) {
+        this->close();
+    }
+}
+
+bool othelloCorpusWriter::open(const std::string &fileName) {
+    if (boardSquares > 64) {
+        return false;
+    }
+
+    this->ofs.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!this->ofs.good()) {
+        return false;
+    }
+
+    corpusHeader header = {};
+    std::memcpy(header.magic, corpusMagic, sizeof(corpusMagic));
+    header.version = corpusVersion;
+    header.recordSize = sizeof(corpusRecord);
+    header.boardSide = (boardSide == 8) ? 0 : boardSide;
+    this->ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->count = 0;
+    return this->ofs.good();
+}
+
+bool othelloCorpusWriter::add(const corpusRecord &record) {
+    this->ofs.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    this->count++;
+    return this->ofs.good();
+}
+
+bool othelloCorpusWriter::close() {
+    this->ofs.close();
+    return !this->ofs.fail();
+}
+
+uint64_t othelloCorpusWriter::size() const {
+    return this->count;
+}
+
+othelloCorpusReader::~othelloCorpusReader() {
+    this->close();
+}
+
+/**
+ * @brief 以只读方式映射局面集
+ *
+ * 校验文件头后直接把记录区当作数组使用；文件末尾不完整的记录被忽略，
+ * 因此可以读取仍在写入中的文件。
+ *
+ * @param fileName 局面集文件
+ * @return 文件头有效时返回 true
+ */
+bool othelloCorpusReader::open(const std::string &fileName) {
+    this->close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        this->message = fileName + ": file does not exist";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(corpusHeader)) {
+        ::close(fd);
+        this->message = fileName + ": not a position corpus";
+        return false;
+    }
+
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        this->message = fileName + ": could not map file";
+        return false;
+    }
+
+    const corpusHeader *header = static_cast<const corpusHeader *>(addr);
+    if (std::memcmp(header->magic, corpusMagic, sizeof(corpusMagic)) != 0
+            || header->version != corpusVersion
+            || header->recordSize != sizeof(corpusRecord)) {
+        munmap(addr, st.st_size);
+        this->message = fileName + ": not a position corpus";
+        return false;
+    }
+    if ((header->boardSide == 0 ? 8 : (int) header->boardSide) != boardSide) {
+        munmap(addr, st.st_size);
+        this->message = fileName + ": corpus of a different board size";
+        return false;
+    }
+
+    this->mapping = addr;
+    this->mappingSize = st.st_size;
+    this->count = (st.st_size - sizeof(corpusHeader)) / sizeof(corpusRecord);
+    this->records = reinterpret_cast<const corpusRecord *>(
+            static_cast<const char *>(addr) + sizeof(corpusHeader));
+    this->message.clear();
+    return true;
+}
+
+void othelloCorpusReader::close() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mappingSize);
+    }
+    this->mapping = nullptr;
+    this->records = nullptr;
+    this->count = 0;
+}
+
+uint64_t othelloCorpusReader::size() const {
+    return this->count;
+}
+
+const corpusRecord &othelloCorpusReader::operator[](uint64_t index) const {
+    return this->records[index];
+}
+
+const corpusRecord *othelloCorpusReader::begin() const {
+    return this->records;
+}
+
+const corpusRecord *othelloCorpusReader::end() const {
+    return this->records + this->count;
+}
+
+const std::string &othelloCorpusReader::error() const {
+    return this->message;
+}
@@ -0,0 +1,117 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstdint>
+#include <fstream>
+#include "board.hpp"
+
+// On-disk layout of a position corpus: a header followed by fixed-size,
+// 8-byte aligned records, so that a mapped file can be indexed directly.
+// The number of records follows from the file size, so a corpus can be
+// appended to and read while it is being written.
+// Records hold boards of up to 64 squares; on larger boards a corpus can
+// neither be written nor read.
+struct corpusHeader {
+    char magic[8];          // "OTTOPOSN"
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t boardSide;     // 0 for the standard 8x8 board
+    uint32_t reserved[3];
+};
+
+struct corpusRecord {
+    uint64_t black;         // bit i set for a black disc on square i
+    uint64_t white;
+    int32_t score;          // from the side to move, if hasScore
+    int8_t toMove;          // 1 black, -1 white
+    uint8_t flags;          // see corpusFlags
+    int8_t move;            // best move as a square index, if hasMove
+    uint8_t depth;          // search depth of a heuristic score
+
+    // Converts from and to the board representation
+    static corpusRecord fromBoard(const othelloBoard &board, int toMove);
+    void toBoard(othelloBoard &board) const;
+};
+
+static_assert(sizeof(corpusRecord) == 24, "corpus records must be 24 bytes");
+
+// corpusRecord::flags
+enum corpusFlags : uint8_t {
+    hasScore = 1,
+    // score is the exact final disc difference rather than an evaluation
+    exactScore = 2,
+    hasMove = 4
+};
+
+const char corpusMagic[8] = {'O', 'T', 'T', 'O', 'P', 'O', 'S', 'N'};
+const uint32_t corpusVersion = 1;
+// Squares a record holds on this board: all of them, unless there are more
+// than 64
+const int corpusSquares = (boardSquares <= 64) ? boardSquares : 64;
+
+// Returns true if fileName starts with a corpus header
+bool isCorpusFile(const std::string &fileName);
+
+// Parses the label of a text position, the text after ';': a score,
+// optionally followed by "exact" or "dN" (search depth) and a best move
+// such as "C4". Returns false if there is no score.
+bool parseCorpusLabel(const std::string &text, corpusRecord &record);
+
+// Formats the label of a record in the syntax of parseCorpusLabel, empty
+// if it has neither score nor move
+std::string corpusLabel(const corpusRecord &record);
+
+// Formats a record as a line of the text position format, with its label
+std::string corpusLine(const corpusRecord &record);
+
+// Appends records to a corpus file
+class othelloCorpusWriter {
+    public:
+        othelloCorpusWriter() {}
+        ~othelloCorpusWriter();
+
+        othelloCorpusWriter(const othelloCorpusWriter &) = delete;
+        othelloCorpusWriter &operator=(const othelloCorpusWriter &) = delete;
+
+        // Creates (or truncates) fileName and writes the header. Fails on
+        // boards of more than 64 squares.
+        bool open(const std::string &fileName);
+        bool add(const corpusRecord &record);
+        bool close();
+
+        uint64_t size() const;
+
+    private:
+        std::ofstream ofs;
+        uint64_t count = 0;
+};
+
+// Memory-mapped corpus. Records are read in place, without parsing.
+class othelloCorpusReader {
+    public:
+        othelloCorpusReader() {}
+        ~othelloCorpusReader();
+
+        othelloCorpusReader(const othelloCorpusReader &) = delete;
+        othelloCorpusReader &operator=(const othelloCorpusReader &) = delete;
+
+        // Returns false and sets error() if the file is not a corpus
+        bool open(const std::string &fileName);
+        void close();
+
+        uint64_t size() const;
+        const corpusRecord &operator[](uint64_t index) const;
+        const corpusRecord *begin() const;
+        const corpusRecord *end() const;
+
+        const std::string &error() const;
+
+    private:
+        const corpusRecord *records = nullptr;
+        uint64_t count = 0;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        std::string message;
+};
+
+#endif // CORPUS_HPP
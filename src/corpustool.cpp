@@ -0,0 +1,242 @@
+// Position corpus converter and sampler.
+//
+// Usage: corpustool.exe pack --output FILE INPUT...
+//        corpustool.exe unpack [--output FILE] CORPUS
+//        corpustool.exe sample --count N [--seed N] --output FILE CORPUS
+//        corpustool.exe stats CORPUS
+//
+// pack converts positions in the one-line format of --analyze to a binary
+// position corpus (see corpus.hpp), keeping labels written after ';' as a
+// score, "exact" or "dN" and a best move (as written by selfplay.exe). Save
+// files (such as test/board1.txt) are converted as well, without labels.
+// unpack converts back. sample copies N records drawn uniformly at random
+// (without replacement) to a new corpus. stats counts the records, labels
+// and empty squares and times a full pass over the mapped file.
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include "analysis.hpp"
+#include "corpus.hpp"
+
+/**
+ * @brief 将文本局面转换为二进制局面集
+ *
+ * 单行格式的文件逐行转换并保留标签；其他文件按存档文件读取。
+ *
+ * @param output 输出局面集文件
+ * @param inputs 文本局面文件
+ * @return 成功时返回 0
+ */
+int pack(const std::string &output, const std::vector<std::string> &inputs) {
+    othelloCorpusWriter writer;
+    if (!writer.open(output)) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    for (const std::string &input : inputs) {
+        std::ifstream ifs(input.c_str());
+        if (!ifs.good()) {
+            std::cout << input << ": file does not exist" << std::endl;
+            return 1;
+        }
+
+        // A file that does not start with a one-line position is a save
+        // file (see README), read as --analyze reads it
+        std::string line, first;
+        while (first.empty() && std::getline(ifs, line)) {
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start != std::string::npos && line[start] != '#'
+                    && line[start] != ';') {
+                first = line.substr(start,
+                        line.find_first_of(" \t\r;#", start) - start);
+            }
+        }
+        if (!first.empty() && (int) first.length() != boardSquares) {
+            std::vector<analysisTask> tasks;
+            std::string error;
+            if (!readPositions(input, searchLimits(), tasks, error)) {
+                std::cout << error << std::endl;
+                return 1;
+            }
+            for (const analysisTask &task : tasks) {
+                writer.add(corpusRecord::fromBoard(task.board, task.toMove));
+            }
+            continue;
+        }
+        ifs.clear();
+        ifs.seekg(0);
+
+        int lineNum = 0;
+        while (std::getline(ifs, line)) {
+            lineNum++;
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start == std::string::npos || line[start] == '#'
+                    || line[start] == ';') {
+                continue;
+            }
+
+            analysisTask task;
+            if (!parsePositionLine(line, task)) {
+                std::cout << input << ":" << lineNum << ": invalid position"
+                    << std::endl;
+                return 1;
+            }
+            corpusRecord record = corpusRecord::fromBoard(task.board,
+                    task.toMove);
+            size_t semicolon = line.find(';');
+            if (semicolon != std::string::npos) {
+                parseCorpusLabel(line.substr(semicolon + 1), record);
+            }
+            writer.add(record);
+        }
+    }
+
+    uint64_t count = writer.size();
+    if (!writer.close()) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << count << " positions written to " << output << std::endl;
+    return 0;
+}
+
+int unpack(const othelloCorpusReader &corpus, std::ostream &os) {
+    for (const corpusRecord &record : corpus) {
+        os << corpusLine(record) << '\n';
+    }
+    return 0;
+}
+
+int sample(const othelloCorpusReader &corpus, uint64_t count, unsigned seed,
+        const std::string &output) {
+    othelloCorpusWriter writer;
+    if (!writer.open(output)) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    // Selection sampling keeps the records in corpus order
+    std::mt19937_64 rng(seed);
+    uint64_t needed = std::min(count, corpus.size());
+    for (uint64_t i = 0; i < corpus.size() && needed > 0; i++) {
+        if (rng() % (corpus.size() - i) < needed) {
+            writer.add(corpus[i]);
+            needed--;
+        }
+    }
+
+    uint64_t written = writer.size();
+    if (!writer.close()) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << written << " positions written to " << output << std::endl;
+    return 0;
+}
+
+int stats(const othelloCorpusReader &corpus) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t scored = 0, exact = 0, moves = 0;
+    std::vector<uint64_t> empties(boardSquares + 1, 0);
+    for (const corpusRecord &record : corpus) {
+        scored += (record.flags & hasScore) ? 1 : 0;
+        exact += (record.flags & exactScore) ? 1 : 0;
+        moves += (record.flags & hasMove) ? 1 : 0;
+        empties[boardSquares
+            - __builtin_popcountll(record.black | record.white)]++;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << corpus.size() << " positions, " << scored << " scored ("
+        << exact << " exact), " << moves << " with a best move" << std::endl;
+    std::cout << "Scanned in " << elapsed.count() << "s ("
+        << (long long) (corpus.size() / std::max(elapsed.count(), 1e-9))
+        << " positions/s)" << std::endl;
+    std::cout << "empties  positions" << std::endl;
+    for (int i = 0; i <= boardSquares; i++) {
+        if (empties[i] > 0) {
+            std::cout << std::setw(7) << i << std::setw(11) << empties[i]
+                << std::endl;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string command = (argc > 1) ? argv[1] : "";
+    std::string output;
+    uint64_t count = 0;
+    unsigned seed = 1;
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) {
+                inputs.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--output") {
+                output = value;
+            }
+            else if (arg == "--count") {
+                count = std::stoull(value);
+            }
+            else if (arg == "--seed") {
+                seed = std::stoul(value);
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    if (command == "pack" && !output.empty() && !inputs.empty()) {
+        return pack(output, inputs);
+    }
+    if ((command == "unpack" || command == "stats"
+                || (command == "sample" && !output.empty()))
+            && inputs.size() == 1) {
+        othelloCorpusReader corpus;
+        if (!corpus.open(inputs[0])) {
+            std::cout << corpus.error() << std::endl;
+            return 1;
+        }
+        if (command == "stats") {
+            return stats(corpus);
+        }
+        if (command == "sample") {
+            return sample(corpus, count, seed, output);
+        }
+
+        std::ofstream ofs;
+        if (!output.empty()) {
+            ofs.open(output.c_str());
+            if (!ofs.good()) {
+                std::cout << "Could not write " << output << std::endl;
+                return 1;
+            }
+        }
+        return unpack(corpus, output.empty() ? std::cout : ofs);
+    }
+
+    std::cout << "Usage: corpustool.exe pack --output FILE INPUT..." << std::endl
+        << "       corpustool.exe unpack [--output FILE] CORPUS" << std::endl
+        << "       corpustool.exe sample --count N [--seed N] --output FILE CORPUS"
+        << std::endl << "       corpustool.exe stats CORPUS" << std::endl;
+    return 1;
+}
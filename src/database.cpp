@@ -1,43 +1,172 @@
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "database.hpp"
 
-othelloDatabase::othelloDatabase() {
-    this->loadOpenings();
+std::string othelloDatabase::bookFile = "../lib/openings.bin";
+
+othelloDatabase::othelloDatabase(std::string fileName) {
+    this->loadOpenings(fileName);
+}
+
+othelloDatabase::~othelloDatabase() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mappingSize);
+    }
+}
+
+/**
+ * @brief 获取进程内共享的开局库
+ *
+ * 开局库在第一次调用时才映射到内存（函数内静态变量的初始化是线程安全的），
+ * 之后所有玩家与对局共享同一个只读实例。
+ *
+ * @return 共享的开局库
+ */
+const othelloDatabase &othelloDatabase::instance() {
+    static const othelloDatabase book(bookFile);
+    return book;
 }
 
 /**
  * @brief 加载开局库
  *
- * 从指定文件中加载开局数据到开局库中。
+ * 将编译好的二进制开局库（由 compilebook.exe 生成）以只读方式映射到内存中。
+ * 文件头校验失败、文件不存在或棋盘不是 8x8 时，开局库视为空库。
+ *
+ * @param fileName 二进制开局库文件路径
+ */
+void othelloDatabase::loadOpenings(std::string fileName) {
+    // The book holds openings of the standard board only
+    if (boardSide != 8) {
+        return;
+    }
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(bookHeader)) {
+        close(fd);
+        return;
+    }
+
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return;
+    }
+
+    // Validate header before trusting the entry table
+    const bookHeader *header = static_cast<const bookHeader *>(addr);
+    if (std::memcmp(header->magic, bookMagic, sizeof(bookMagic)) != 0
+            || header->version != bookVersion
+            || header->entrySize != sizeof(bookEntry)
+            || sizeof(bookHeader) + header->count*sizeof(bookEntry)
+                > (uint64_t) st.st_size) {
+        std::cout << "Invalid opening book " << fileName << "!" << std::endl;
+        munmap(addr, st.st_size);
+        return;
+    }
+
+    this->mapping = addr;
+    this->mappingSize = st.st_size;
+    this->count = header->count;
+    this->entries = reinterpret_cast<const bookEntry *>(
+            static_cast<const char *>(addr) + sizeof(bookHeader));
+}
+
+/**
+ * @brief 查询开局库
  *
- * 文件格式应为每行包含两部分，第一部分为历史走法，第二部分为对应的下一步走法（以整数形式表示）。
- * 每两步走法占一行，以换行符分隔。
+ * 对按键排序的条目表进行二分查找。
  *
- * @note 该函数将文件 "../lib/openings.txt" 中的数据读入到成员变量 openingBook 中。
+ * @param moveHistory 走法历史记录，例如 "26,18,19,"
+ * @return 开局库中的下一步走法，未找到时返回 -1
  */
-void othelloDatabase::loadOpenings() {
-    // 打开文件
-    std::ifstream csv("../lib/openings.txt");
-
-    // 定义字符串变量用于存储过去的走法和下一个走法
-    std::string pastMoves;
-    std::string nextMove;
-    // 定义整型变量用于存储解析后的下一个走法
-    int nextMoveInt;
-
-    // 循环读取文件中的每一行
-    while (getline(csv, pastMoves)) {
-        // 读取下一个走法
-        getline(csv, nextMove);
-        // 将字符串类型的下一个走法转换为整型
-        nextMoveInt = std::stoi(nextMove);
-
-        // 输出过去的走法（此行代码被注释掉）
-        //std::cout << pastMoves << std::endl;
-        // 输出解析后的下一个走法（此行代码被注释掉）
-        //std::cout << nextMoveInt << std::endl;
-
-        // 将过去的走法和下一个走法添加到开局数据库中
-        // {pastMoves, nextMoveInt} 表示一对键值对，其中键为过去的走法，值为下一个走法
-        openingBook.insert({pastMoves, nextMoveInt});
+int othelloDatabase::probe(const std::string &moveHistory) const {
+    uint64_t key = hashHistory(moveHistory);
+    const bookEntry *first = this->entries;
+    const bookEntry *last = this->entries + this->count;
+
+    const bookEntry *it = std::lower_bound(first, last, key,
+            [](const bookEntry &entry, uint64_t k) { return entry.key < k; });
+
+    if (it != last && it->key == key) {
+        return it->move;
+    }
+    return -1;
+}
+
+uint64_t othelloDatabase::size() const {
+    return this->count;
+}
+
+// 64-bit FNV-1a hash of the move history string
+uint64_t othelloDatabase::hashHistory(const std::string &moveHistory) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char ch : moveHistory) {
+        hash ^= ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief 按键排序并去重后写出二进制开局库
+ *
+ * @param fileName 输出文件名
+ * @param book 开局库条目，写出前会被排序
+ * @return 写出成功时返回 true
+ */
+bool othelloDatabase::writeBook(const std::string &fileName,
+        std::vector<bookEntry> &book) {
+    // Stable sort so that the first occurrence of a key survives unique()
+    std::stable_sort(book.begin(), book.end(),
+            [](const bookEntry &a, const bookEntry &b) { return a.key < b.key; });
+    book.erase(std::unique(book.begin(), book.end(),
+                [](const bookEntry &a, const bookEntry &b) { return a.key == b.key; }),
+            book.end());
+
+    bookHeader header = {};
+    std::memcpy(header.magic, bookMagic, sizeof(bookMagic));
+    header.version = bookVersion;
+    header.entrySize = sizeof(bookEntry);
+    header.count = book.size();
+
+    std::ofstream ofs(fileName.c_str(), std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(book.data()),
+            book.size()*sizeof(bookEntry));
+
+    return ofs.good();
+}
+
+/**
+ * @brief 将目录格式的走法序列转换为走法索引列表
+ *
+ * @param line 形如 "C4c3D3c5B3" 的走法序列
+ * @param squares 输出的棋盘索引列表
+ * @return 序列合法时返回 true
+ */
+bool othelloDatabase::parseCatalogueLine(const std::string &line, std::vector<int> &squares) {
+    squares.clear();
+    if (line.length() % 2 != 0) {
+        return false;
     }
+
+    for (size_t i = 0; i < line.length(); i += 2) {
+        int square = squareIndex(line.substr(i, 2));
+        if (square < 0) {
+            return false;
+        }
+        squares.push_back(square);
+    }
+
+    return !squares.empty();
 }
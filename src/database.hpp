@@ -1,15 +1,70 @@
 #ifndef DATABASE_HPP
 #define DATABASE_HPP
 
+#include <cstdint>
 #include <fstream>
 #include "board.hpp"
 
+// On-disk layout of the compiled opening book (see compilebook.cpp).
+// The file is a header followed by entries sorted by key, so that it can be
+// memory-mapped and probed with a binary search without any parsing.
+struct bookHeader {
+    char magic[8];          // "OTTOBOOK"
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t count;
+};
+
+struct bookEntry {
+    uint64_t key;           // hash of the move history, see hashHistory()
+    int32_t move;           // next move, as a square index 0-63
+    int32_t score;          // backed-up value of the move, 0 if unknown
+};
+
+const char bookMagic[8] = {'O', 'T', 'T', 'O', 'B', 'O', 'O', 'K'};
+const uint32_t bookVersion = 1;
+
 class othelloDatabase {
     public:
-        std::unordered_map<std::string, int> openingBook = {};
+        // Maps the compiled book; an unreadable book behaves as empty
+        othelloDatabase(std::string fileName = "../lib/openings.bin");
+        ~othelloDatabase();
+
+        othelloDatabase(const othelloDatabase &) = delete;
+        othelloDatabase &operator=(const othelloDatabase &) = delete;
+
+        // Process-wide book shared by every player and game. The book file
+        // is mapped on the first call, which is safe from any thread.
+        static const othelloDatabase &instance();
+
+        // Book file used by instance(); must be set before the first probe
+        static std::string bookFile;
+
+        // Returns the book move following moveHistory, or -1 if unknown
+        int probe(const std::string &moveHistory) const;
+
+        // Number of entries in the book
+        uint64_t size() const;
+
+        // Hashes a move history string ("26,18,19,") into a book key
+        static uint64_t hashHistory(const std::string &moveHistory);
+
+        // Converts a catalogue sequence ("C4c3D3c5B3") to square indices
+        static bool parseCatalogueLine(const std::string &line,
+                std::vector<int> &squares);
+
+        // Sorts book by key, drops duplicate keys (first entry wins) and
+        // writes it in the compiled format
+        static bool writeBook(const std::string &fileName,
+                std::vector<bookEntry> &book);
+
+    private:
+        const bookEntry *entries = nullptr;
+        uint64_t count = 0;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
 
-        othelloDatabase();
-        void loadOpenings();
+        void loadOpenings(std::string fileName);
 };
 
 #endif // DATABASE_HPP
@@ -0,0 +1,261 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "endgame.hpp"
+
+othelloEndgameCache::~othelloEndgameCache() {
+    this->close();
+}
+
+// Maps the cache file, creating it under an exclusive lock if needed
+/**
+ * @brief 打开残局缓存文件
+ *
+ * 文件不存在或为空时，在排他锁下写入文件头并扩展到固定大小，因此多个进程
+ * 同时打开同一文件时只有一个进程创建它。已有文件保持原有大小。文件头记录
+ * 散列键与棋盘大小，与当前构建不一致的文件会被拒绝。
+ *
+ * @param fileName 缓存文件
+ * @param bytes 新建文件的大小上限
+ * @param readOnly 为 true 时只读映射，store 不写入
+ * @return 映射成功时返回 true，否则设置 error()
+ */
+bool othelloEndgameCache::open(const std::string &fileName, size_t bytes,
+        bool readOnly) {
+    this->close();
+
+    int fd = ::open(fileName.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT,
+            0644);
+    if (fd < 0) {
+        this->message = fileName + (readOnly ? ": file does not exist"
+                : ": could not open file");
+        return false;
+    }
+
+    flock(fd, readOnly ? LOCK_SH : LOCK_EX);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        this->message = fileName + ": could not open file";
+        return false;
+    }
+
+    if (st.st_size == 0 && !readOnly) {
+        uint64_t count = 1;
+        while (2*count*sizeof(slot) <= bytes) {
+            count *= 2;
+        }
+
+        endgameCacheHeader header = {};
+        std::memcpy(header.magic, endgameCacheMagic, sizeof(endgameCacheMagic));
+        header.version = endgameCacheVersion;
+        header.slotSize = sizeof(slot);
+        header.slots = count;
+        header.seed = othelloTable::keySeed();
+        header.keyCheck = othelloTable::keyCheck();
+        header.boardSide = boardSide;
+        st.st_size = sizeof(header) + count*sizeof(slot);
+        // The slots are zero, that is empty, as the file is extended
+        if (ftruncate(fd, st.st_size) != 0
+                || pwrite(fd, &header, sizeof(header), 0)
+                    != (ssize_t) sizeof(header)) {
+            unlink(fileName.c_str());
+            ::close(fd);
+            this->message = fileName + ": could not write file";
+            return false;
+        }
+    }
+
+    void *addr = (st.st_size < (off_t) sizeof(endgameCacheHeader))
+        ? MAP_FAILED
+        : mmap(nullptr, st.st_size, PROT_READ | (readOnly ? 0 : PROT_WRITE),
+                MAP_SHARED, fd, 0);
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        this->message = fileName + ": not an endgame cache";
+        return false;
+    }
+
+    const endgameCacheHeader *header =
+        static_cast<const endgameCacheHeader *>(addr);
+    uint64_t count = header->slots;
+    if (std::memcmp(header->magic, endgameCacheMagic,
+                sizeof(endgameCacheMagic)) != 0
+            || header->version != endgameCacheVersion
+            || header->slotSize != sizeof(slot)
+            || count == 0 || (count & (count - 1)) != 0
+            || sizeof(endgameCacheHeader) + count*sizeof(slot)
+                > (uint64_t) st.st_size) {
+        munmap(addr, st.st_size);
+        this->message = fileName + ": not an endgame cache";
+        return false;
+    }
+    if (header->seed != othelloTable::keySeed()
+            || header->keyCheck != othelloTable::keyCheck()
+            || header->boardSide != (uint32_t) boardSide) {
+        munmap(addr, st.st_size);
+        this->message = fileName
+            + ": endgame cache uses other hash keys or another board size";
+        return false;
+    }
+
+    this->mapping = addr;
+    this->mappingSize = st.st_size;
+    this->slots = reinterpret_cast<slot *>(
+            static_cast<char *>(addr) + sizeof(endgameCacheHeader));
+    this->mask = count - 1;
+    this->writable = !readOnly;
+    this->message.clear();
+    return true;
+}
+
+// Unmapping leaves the results in the page cache, from where the kernel
+// writes them to the file
+void othelloEndgameCache::close() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mappingSize);
+    }
+    this->mapping = nullptr;
+    this->mappingSize = 0;
+    this->slots = nullptr;
+    this->mask = 0;
+    this->writable = false;
+}
+
+bool othelloEndgameCache::isOpen() const {
+    return this->slots != nullptr;
+}
+
+uint64_t othelloEndgameCache::hash(const othelloBoard &board, int toMove,
+        int &symmetry) {
+    return othelloTable::canonicalHash(board, toMove, symmetry);
+}
+
+// Layout: score + boardSquares + 1 (8 bits, never zero), bound (2), move + 1
+// (7), where the move is on the board the key was taken from
+uint64_t othelloEndgameCache::pack(const tableEntry &entry, int symmetry) {
+    int move = (entry.move >= 0)
+        ? othelloTable::symmetricSquare(entry.move, symmetry) : -1;
+    return (uint64_t) (entry.score + boardSquares + 1)
+        | (uint64_t) entry.bound << 8
+        | (uint64_t) (move + 1) << 10;
+}
+
+void othelloEndgameCache::unpack(uint64_t data, int symmetry,
+        tableEntry &entry) {
+    entry.score = (int) (data & 0xff) - boardSquares - 1;
+    entry.depth = 0;
+    entry.bound = static_cast<boundType>((data >> 8) & 0x3);
+    int move = (int) ((data >> 10) & 0x7f) - 1;
+    entry.move = (move >= 0) ? othelloTable::symmetricSquare(move,
+            othelloTable::inverseSymmetry(symmetry)) : -1;
+}
+
+// Looks for the key among the slots following its home slot
+/**
+ * @brief 查询残局缓存
+ *
+ * 从键对应的槽开始依次检查，遇到空槽即停止：槽一旦被占用就不会再清空，
+ * 因此键只可能出现在第一个空槽之前。
+ *
+ * @param key hash 返回的键
+ * @param symmetry hash 写入的对称变换
+ * @param entry 命中时写入分数、界的类型与最佳走法
+ * @return 命中时返回 true
+ */
+bool othelloEndgameCache::probe(uint64_t key, int symmetry,
+        tableEntry &entry) const {
+    if (this->slots == nullptr) {
+        return false;
+    }
+
+    for (int i = 0; i < probeLimit; i++) {
+        const slot &s = this->slots[(key + i) & this->mask];
+        uint64_t data = s.data.load(std::memory_order_acquire);
+        if (data == 0) {
+            return false;
+        }
+        if ((s.check.load(std::memory_order_acquire) ^ data) == key) {
+            unpack(data, symmetry, entry);
+            return entry.bound != boundType::none;
+        }
+    }
+
+    return false;
+}
+
+// Claims an empty slot for the key, or improves its existing entry
+/**
+ * @brief 写入残局缓存
+ *
+ * 用比较交换占用空槽或替换同一局面的结果，再写入校验值。两步之间读到该槽
+ * 的进程只会校验失败而不命中；同时写入的进程中只有比较交换成功的一个生效。
+ * 精确值不会被替换，界只会被精确值或同类更紧的界替换。
+ *
+ * @param key hash 返回的键
+ * @param symmetry hash 写入的对称变换
+ * @param entry 分数（以走棋方计的子数差）、界的类型与最佳走法
+ * @return 写入时返回 true
+ */
+bool othelloEndgameCache::store(uint64_t key, int symmetry,
+        const tableEntry &entry) {
+    if (!this->writable || entry.bound == boundType::none
+            || entry.score < -boardSquares || entry.score > boardSquares) {
+        return false;
+    }
+
+    uint64_t data = pack(entry, symmetry);
+    for (int i = 0; i < probeLimit; i++) {
+        slot &s = this->slots[(key + i) & this->mask];
+        uint64_t old = s.data.load(std::memory_order_acquire);
+        if (old == 0) {
+            if (s.data.compare_exchange_strong(old, data,
+                        std::memory_order_acq_rel)) {
+                s.check.store(key ^ data, std::memory_order_release);
+                return true;
+            }
+        }
+        if ((s.check.load(std::memory_order_acquire) ^ old) != key) {
+            continue;
+        }
+
+        tableEntry current;
+        unpack(old, 0, current);
+        bool better = (current.bound != boundType::exact)
+            && (entry.bound == boundType::exact
+                || (entry.bound == current.bound
+                    && (entry.bound == boundType::lower
+                        ? entry.score > current.score
+                        : entry.score < current.score)));
+        if (!better || !s.data.compare_exchange_strong(old, data,
+                    std::memory_order_acq_rel)) {
+            return false;
+        }
+        s.check.store(key ^ data, std::memory_order_release);
+        return true;
+    }
+
+    return false;
+}
+
+size_t othelloEndgameCache::size() const {
+    return (this->slots == nullptr) ? 0 : this->mask + 1;
+}
+
+size_t othelloEndgameCache::used() const {
+    size_t count = 0;
+    for (size_t i = 0; i < this->size(); i++) {
+        if (this->slots[i].data.load(std::memory_order_relaxed) != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const std::string &othelloEndgameCache::error() const {
+    return this->message;
+}
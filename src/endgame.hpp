@@ -0,0 +1,104 @@
+#ifndef ENDGAME_HPP
+#define ENDGAME_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "table.hpp"
+
+// On-disk layout of an endgame cache: a header followed by a power-of-two
+// number of 16-byte slots, so that the mapped file is the hash table. The
+// keys and the board size of the build that created the file are recorded,
+// as the slots are only meaningful to builds that share them.
+struct endgameCacheHeader {
+    char magic[8];          // "OTTOENDG"
+    uint32_t version;
+    uint32_t slotSize;
+    uint64_t slots;
+    uint64_t seed;          // othelloTable::keySeed()
+    uint64_t keyCheck;      // othelloTable::keyCheck()
+    uint32_t boardSide;
+    uint32_t reserved;
+};
+
+const char endgameCacheMagic[8] = {'O', 'T', 'T', 'O', 'E', 'N', 'D', 'G'};
+const uint32_t endgameCacheVersion = 2;
+
+// Solved endgame positions kept in a memory-mapped file, so that results
+// survive the process and are shared by every engine on the host that maps
+// the same file. Scores are final disc differences from the side to move,
+// either exact or a bound; a lower bound above zero is a proven win and an
+// upper bound below zero a proven loss. Positions are keyed by
+// othelloTable::canonicalHash, so symmetric positions share an entry.
+//
+// Entries are only ever added: a slot, once claimed, keeps its position,
+// and its result is only replaced by an exact one. Slots are claimed with
+// a compare-and-swap on the mapped memory and verified like the
+// transposition table's, so any number of processes can probe and store
+// at once without locks. The file size is fixed when it is created; when
+// every slot near a key is taken, the result is not stored.
+class othelloEndgameCache {
+    public:
+        // Size of a new cache file when open is not given one
+        static const size_t defaultBytes = 64 << 20;
+
+        othelloEndgameCache() {}
+        ~othelloEndgameCache();
+
+        othelloEndgameCache(const othelloEndgameCache &) = delete;
+        othelloEndgameCache &operator=(const othelloEndgameCache &) = delete;
+
+        // Maps fileName, creating it with the largest power-of-two number
+        // of slots that fits in bytes if it does not exist. An existing file
+        // keeps its size. A read-only cache never stores. Returns false and
+        // sets error() if the file is not an endgame cache or was created by
+        // a build with other hash keys or another board size.
+        bool open(const std::string &fileName, size_t bytes = defaultBytes,
+                bool readOnly = false);
+        void close();
+        bool isOpen() const;
+
+        // Key of a position with toMove to move; symmetry is passed on to
+        // probe and store to map the best move
+        static uint64_t hash(const othelloBoard &board, int toMove,
+                int &symmetry);
+
+        // entry.score is the disc difference from the side to move; depth
+        // is unused
+        bool probe(uint64_t key, int symmetry, tableEntry &entry) const;
+        bool store(uint64_t key, int symmetry, const tableEntry &entry);
+
+        // Positions with fewer empty squares are solved faster than they
+        // are looked up, and are not cached
+        int minEmpties = 6;
+
+        size_t size() const;
+        // Slots in use, counted by scanning the whole file
+        size_t used() const;
+
+        const std::string &error() const;
+
+    private:
+        struct slot {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        // Slots probed from a key's home slot before giving up
+        static const int probeLimit = 8;
+
+        slot *slots = nullptr;
+        size_t mask = 0;
+        bool writable = false;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        std::string message;
+
+        static uint64_t pack(const tableEntry &entry, int symmetry);
+        static void unpack(uint64_t data, int symmetry, tableEntry &entry);
+};
+
+static_assert(sizeof(endgameCacheHeader) == 48,
+        "endgame cache headers must be 48 bytes");
+
+#endif // ENDGAME_HPP
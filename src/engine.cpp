@@ -0,0 +1,535 @@
+// Text protocol engine mode.
+//
+// Usage: othello.exe --engine [--hash MB] [--hash-file FILE]
+//                             [--shared-hash NAME] [--huge-pages on|off]
+//                             [--numa local|interleave]
+//
+// Commands are read one per line from stdin; replies are written to stdout.
+// A search started by "go" or "ponder" runs in the background, so "stop",
+// "isready" and "quit" are answered while it is running. Any other command
+// stops the running search first.
+//
+// --hash gives the searcher a transposition table of MB megabytes. With
+// --hash-file, the table is loaded from FILE at startup, if it exists, and
+// written back on exit, so a restarted engine keeps its search tree.
+// --shared-hash places the table in the named POSIX shared-memory segment
+// NAME instead, so that every engine started with the same name searches
+// on the same entries. Tables use huge pages where the system has them,
+// unless --huge-pages is off, and --numa interleave spreads them over all
+// online memory nodes (an error is sent if that fails).
+
+#include "engine.hpp"
+#include "database.hpp"
+
+othelloEngine::othelloEngine() {
+    std::istringstream startpos("startpos");
+    this->setPosition(startpos);
+    this->player.computer = true;
+}
+
+othelloEngine::~othelloEngine() {
+    this->stopSearch();
+}
+
+int othelloEngine::run(std::istream &is) {
+    std::string line;
+    while (std::getline(is, line)) {
+        if (!this->execute(line)) {
+            this->stopSearch();
+            return 0;
+        }
+    }
+
+    // At end of input, let a bounded search report its move
+    this->waitSearch();
+    return 0;
+}
+
+/**
+ * @brief 执行一条协议命令
+ *
+ * @param line 命令行
+ * @return 收到 quit 时返回 false，否则返回 true
+ */
+bool othelloEngine::execute(const std::string &line) {
+    std::istringstream iss(line);
+    std::string command;
+    if (!(iss >> command)) {
+        return true;
+    }
+
+    if (command == "isready") {
+        this->send("readyok");
+        return true;
+    }
+    if (command == "quit") {
+        return false;
+    }
+
+    // Everything below needs the searcher
+    this->stopSearch();
+
+    if (command == "stop") {
+        // Nothing more to do: the search reports its own best move
+    }
+    else if (command == "new") {
+        std::istringstream startpos("startpos");
+        this->setPosition(startpos);
+    }
+    else if (command == "position") {
+        this->setPosition(iss);
+    }
+    else if (command == "move") {
+        std::string coord;
+        iss >> coord;
+        if (!this->playMove(coord)) {
+            this->send("error illegal move " + coord);
+        }
+    }
+    else if (command == "go") {
+        this->go(iss, false);
+    }
+    else if (command == "ponder") {
+        this->go(iss, true);
+    }
+    else if (command == "hint") {
+        this->hint(iss);
+    }
+    else if (command == "board") {
+        this->printBoard();
+    }
+    else if (command == "hash") {
+        long long megabytes = -1;
+        if (!(iss >> megabytes) || megabytes < 0) {
+            this->send("error invalid hash size");
+        }
+        else {
+            this->setTable((size_t) megabytes << 20);
+        }
+    }
+    else if (command == "savehash" || command == "loadhash") {
+        std::string fileName, error;
+        if (!(iss >> fileName)) {
+            this->send("error missing file");
+        }
+        else if (command == "savehash"
+                ? !this->saveTable(fileName, error)
+                : !this->loadTable(fileName, error)) {
+            this->send("error " + error);
+        }
+        else {
+            this->send(command == "savehash" ? "hashsaved" : "hashloaded");
+        }
+    }
+    else {
+        this->send("error unknown command " + command);
+    }
+
+    return true;
+}
+
+/**
+ * @brief 设置局面
+ *
+ * 格式为 "startpos" 或 "<boardSquares 格> <轮到的一方>"，其后可跟 "moves <走法>..."。
+ *
+ * @param iss 命令余下部分
+ */
+void othelloEngine::setPosition(std::istringstream &iss) {
+    std::string token;
+    if (!(iss >> token)) {
+        this->send("error missing position");
+        return;
+    }
+
+    if (token == "startpos") {
+        this->board.startPosition();
+        this->toMove = 1;
+        this->moveHistory.clear();
+        this->bookUsable = true;
+    }
+    else {
+        std::string side;
+        iss >> side;
+        analysisTask task;
+        if (!parsePositionLine(token + " " + side, task)) {
+            this->send("error invalid position");
+            return;
+        }
+        this->board.positions = task.board.positions;
+        this->board.discsOnBoard = task.board.discsOnBoard;
+        this->toMove = task.toMove;
+        this->moveHistory.clear();
+        this->bookUsable = false;
+    }
+    this->board.passes[0] = false;
+    this->board.passes[1] = false;
+
+    if (iss >> token && token == "moves") {
+        while (iss >> token) {
+            if (!this->playMove(token)) {
+                this->send("error illegal move " + token);
+                return;
+            }
+        }
+    }
+}
+
+// Plays a move for the side to move; returns false if it is illegal
+bool othelloEngine::playMove(const std::string &coord) {
+    int square = string2index(coord);
+    this->board.findLegalMoves(this->toMove, &this->board.moves);
+
+    if (square == -1) {
+        if (!this->board.moves.empty()) {
+            return false;
+        }
+        this->bookUsable = false;
+    }
+    else {
+        auto move = this->board.moves.find(square);
+        if (square < 0 || move == this->board.moves.end()) {
+            return false;
+        }
+        this->board.updateBoard(this->toMove, *move);
+        this->board.discsOnBoard++;
+        this->moveHistory.append(std::to_string(square) + ",");
+    }
+
+    this->toMove = -this->toMove;
+    this->board.moves.clear();
+    return true;
+}
+
+/**
+ * @brief 开始后台搜索
+ *
+ * 选项：depth N、movetime MS、nodes N、btime/wtime/binc/winc MS、infinite。
+ * 每完成一次迭代输出一行 info，搜索结束后输出 bestmove（ponder 除外）。
+ *
+ * @param iss 命令余下部分
+ * @param ponder 为 true 时不限时搜索直到 stop，且不输出 bestmove
+ */
+void othelloEngine::go(std::istringstream &iss, bool ponder) {
+    searchLimits limits;
+    float clock[2] = {0.0, 0.0}, increment[2] = {0.0, 0.0};
+    bool infinite = ponder;
+    std::string option;
+    long long value = 0;
+
+    while (iss >> option) {
+        if (option == "infinite") {
+            infinite = true;
+            continue;
+        }
+        if (!(iss >> value)) {
+            this->send("error missing value for " + option);
+            return;
+        }
+
+        if (option == "depth") {
+            limits.depth = value;
+        }
+        else if (option == "movetime") {
+            limits.time = value / 1000.0;
+        }
+        else if (option == "nodes") {
+            limits.nodes = value;
+        }
+        else if (option == "btime") {
+            clock[0] = value / 1000.0;
+        }
+        else if (option == "wtime") {
+            clock[1] = value / 1000.0;
+        }
+        else if (option == "binc") {
+            increment[0] = value / 1000.0;
+        }
+        else if (option == "winc") {
+            increment[1] = value / 1000.0;
+        }
+        else {
+            this->send("error unknown option " + option);
+            return;
+        }
+    }
+
+    // Spread the remaining clock over our remaining moves
+    int side = (this->toMove == 1) ? 0 : 1;
+    if (limits.time <= 0 && clock[side] > 0) {
+        int movesLeft = std::max(1, (boardSquares - this->board.discsOnBoard + 1) / 2);
+        limits.time = std::min(clock[side]/movesLeft + 0.8f*increment[side],
+                0.5f*clock[side]);
+    }
+    if (infinite) {
+        limits.time = 0;
+    }
+
+    this->board.findLegalMoves(this->toMove, &this->board.moves);
+    if (this->board.moves.empty()) {
+        if (!ponder) {
+            this->send("bestmove pass");
+        }
+        return;
+    }
+
+    if (!ponder && !infinite && this->bookUsable) {
+        int bookMove = othelloDatabase::instance().probe(this->moveHistory);
+        if (this->board.moves.find(bookMove) != this->board.moves.end()) {
+            this->send("info book");
+            this->send("bestmove " + index2string(bookMove));
+            return;
+        }
+    }
+
+    othelloBoard root = this->board;
+    this->player.color = this->toMove;
+    this->player.stop = false;
+    this->searching = true;
+    this->unbounded = infinite;
+    this->searchThread = std::thread([this, root, limits, ponder]() mutable {
+        searchResult result = this->player.analyze(root, limits,
+                [this](const searchResult &info) { this->sendInfo(info); });
+        if (!ponder) {
+            this->send("bestmove " + index2string(result.move));
+        }
+    });
+}
+
+/**
+ * @brief 给出多个候选走法
+ *
+ * 格式为 "hint N [depth D] [movetime MS]"，以一次多主要变例搜索求出
+ * 前 N 个走法的精确分数，按分数从高到低输出走法及其主要变例，
+ * 最后输出 "hint done"。
+ *
+ * @param iss 命令余下部分
+ */
+void othelloEngine::hint(std::istringstream &iss) {
+    int count = 1;
+    searchLimits limits;
+    std::string option;
+    long long value = 0;
+
+    iss >> count;
+    while (iss >> option >> value) {
+        if (option == "depth") {
+            limits.depth = value;
+        }
+        else if (option == "movetime") {
+            limits.time = value / 1000.0;
+        }
+    }
+    if (limits.depth <= 0 && limits.time <= 0) {
+        limits.depth = 6;
+    }
+
+    // One multi-PV search scores the best count moves exactly
+    othelloBoard root = this->board;
+    limits.multiPV = std::max(count, 1);
+    this->player.color = this->toMove;
+    this->player.stop = false;
+    searchResult result = this->player.analyze(root, limits);
+    if (result.lines.empty() && result.move != -1) {
+        searchLine best;
+        best.move = result.move;
+        best.score = result.score;
+        best.pv = result.pv;
+        result.lines.push_back(best);
+    }
+
+    for (int i = 0; i < count && i < (int) result.lines.size(); i++) {
+        const searchLine &line = result.lines[i];
+        if (line.bound != boundType::exact) {
+            break;
+        }
+        std::ostringstream oss;
+        oss << "hint " << i + 1 << " move " << index2string(line.move)
+            << " score " << line.score << " depth " << result.depth << " pv";
+        for (int square : line.pv) {
+            oss << " " << index2string(square);
+        }
+        this->send(oss.str());
+    }
+    this->send("hint done");
+}
+
+// Stops a running search and waits for it to finish
+void othelloEngine::stopSearch() {
+    if (!this->searching) {
+        return;
+    }
+
+    this->player.stop = true;
+    this->searchThread.join();
+    this->searching = false;
+    this->unbounded = false;
+}
+
+// Waits for a bounded search to finish on its own
+void othelloEngine::waitSearch() {
+    if (!this->searching || this->unbounded) {
+        this->stopSearch();
+        return;
+    }
+
+    this->searchThread.join();
+    this->searching = false;
+}
+
+void othelloEngine::printBoard() {
+    const char symbols[3] = {'O', '-', 'X'};
+    for (int row = 0; row < boardSide; row++) {
+        std::string line;
+        for (int col = 0; col < boardSide; col++) {
+            line += symbols[this->board.positions[geometry::square(row, col)]
+                + 1];
+        }
+        this->send(line);
+    }
+    this->send(std::string("side ") + (this->toMove == 1 ? "X" : "O"));
+}
+
+void othelloEngine::send(const std::string &line) {
+    std::lock_guard<std::mutex> lock(this->outputMutex);
+    std::cout << line << std::endl;
+}
+
+void othelloEngine::sendInfo(const searchResult &result) {
+    std::ostringstream oss;
+    long long ms = (long long) (1000*result.time);
+    oss << "info depth " << result.depth << " score " << result.score
+        << " nodes " << result.nodes << " time " << ms
+        << " nps " << (long long) (result.nodes / std::max(result.time, 1e-6f))
+        << " pv";
+    for (int square : result.pv) {
+        oss << " " << index2string(square);
+    }
+    this->send(oss.str());
+}
+
+void othelloEngine::setTable(size_t bytes) {
+    this->table.reset(bytes > 0 ? new othelloTable(bytes, this->memory)
+            : nullptr);
+    this->player.table = this->table.get();
+    if (this->table && !this->table->placementError().empty()) {
+        this->send("error " + this->table->placementError());
+    }
+}
+
+bool othelloEngine::shareTable(const std::string &name, size_t bytes,
+        std::string &error) {
+    std::unique_ptr<othelloTable> shared =
+        othelloTable::openShared(name, bytes, error, this->memory);
+    if (!shared) {
+        return false;
+    }
+    this->table = std::move(shared);
+    this->player.table = this->table.get();
+    if (!this->table->placementError().empty()) {
+        this->send("error " + this->table->placementError());
+    }
+    return true;
+}
+
+bool othelloEngine::saveTable(const std::string &fileName,
+        std::string &error) {
+    if (!this->table) {
+        error = "no hash table";
+        return false;
+    }
+    return this->table->save(fileName, error);
+}
+
+bool othelloEngine::loadTable(const std::string &fileName,
+        std::string &error) {
+    if (!this->table) {
+        this->setTable(defaultTableBytes);
+    }
+    return this->table->load(fileName, error);
+}
+
+/**
+ * @brief 引擎模式入口
+ *
+ * 解析 --hash 与 --hash-file。指定快照文件时启动前载入（文件不存在则从空表
+ * 开始），退出时写回。
+ *
+ * @return 参数有误时返回 1，否则返回 0
+ */
+int runEngine(int argc, char **argv) {
+    long long megabytes = -1;
+    std::string hashFile, sharedName;
+    tableMemory memory;
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--hash") {
+                megabytes = std::stoll(value);
+            }
+            else if (arg == "--hash-file") {
+                hashFile = value;
+            }
+            else if (arg == "--shared-hash") {
+                sharedName = value;
+            }
+            else if (arg == "--huge-pages") {
+                if (value != "on" && value != "off") {
+                    throw std::invalid_argument(value);
+                }
+                memory.hugePages = (value == "on");
+            }
+            else if (arg == "--numa") {
+                if (value != "local" && value != "interleave") {
+                    throw std::invalid_argument(value);
+                }
+                memory.interleave = (value == "interleave");
+            }
+            else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cerr << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    othelloEngine engine;
+    engine.memory = memory;
+    std::string error;
+    if (!sharedName.empty()) {
+        if (!engine.shareTable(sharedName, megabytes > 0
+                    ? (size_t) megabytes << 20
+                    : othelloEngine::defaultTableBytes, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+    else if (megabytes > 0) {
+        engine.setTable((size_t) megabytes << 20);
+    }
+    if (!hashFile.empty()) {
+        if (megabytes < 0 && sharedName.empty()) {
+            engine.setTable(othelloEngine::defaultTableBytes);
+        }
+        std::ifstream exists(hashFile.c_str());
+        if (exists.good() && !engine.loadTable(hashFile, error)) {
+            std::cerr << error << std::endl;
+        }
+    }
+
+    int status = engine.run(std::cin);
+    if (!hashFile.empty() && !engine.saveTable(hashFile, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    return status;
+}
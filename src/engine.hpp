@@ -0,0 +1,67 @@
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include <mutex>
+#include <thread>
+#include "analysis.hpp"
+
+// Line-based engine protocol on stdin/stdout for GUIs and tournament
+// managers. See README for the command reference.
+class othelloEngine {
+    public:
+        othelloEngine();
+        ~othelloEngine();
+
+        // Reads commands until "quit" or end of input
+        int run(std::istream &is);
+
+        // Executes a single command line. Returns false on "quit".
+        bool execute(const std::string &line);
+
+        // Replaces the transposition table with an empty one of the given
+        // size; 0 searches without a table
+        void setTable(size_t bytes);
+        // Searches on the table in the named shared-memory segment (see
+        // othelloTable::openShared)
+        bool shareTable(const std::string &name, size_t bytes,
+                std::string &error);
+        // Snapshots the table, or loads a snapshot into it (creating a
+        // table of defaultTableBytes if there is none)
+        bool saveTable(const std::string &fileName, std::string &error);
+        bool loadTable(const std::string &fileName, std::string &error);
+
+        static const size_t defaultTableBytes = 64 << 20;
+        // Huge pages and NUMA placement of tables created from now on
+        tableMemory memory;
+
+    private:
+        othelloBoard board;
+        int toMove = 1;
+        // Move history in the opening book's format; empty after a pass or
+        // a set-up position, where the book cannot be used
+        std::string moveHistory;
+        bool bookUsable = true;
+
+        othelloPlayer player;
+        std::unique_ptr<othelloTable> table;
+        std::thread searchThread;
+        bool searching = false;
+        // The running search only ends on "stop" (ponder, go infinite)
+        bool unbounded = false;
+        std::mutex outputMutex;
+
+        void setPosition(std::istringstream &iss);
+        bool playMove(const std::string &coord);
+        void go(std::istringstream &iss, bool ponder);
+        void hint(std::istringstream &iss);
+        void stopSearch();
+        void waitSearch();
+        void printBoard();
+        void send(const std::string &line);
+        void sendInfo(const searchResult &result);
+};
+
+// Entry point for "othello.exe --engine"
+int runEngine(int argc, char **argv);
+
+#endif // ENGINE_HPP
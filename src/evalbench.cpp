@@ -0,0 +1,261 @@
+// Microbenchmarks for the heuristic features.
+//
+// Usage: evalbench.exe [--positions N] [--seed N] [--repeat N]
+//                      [--corpus FILE] [--save FILE]
+//
+// Times every feature of othelloHeuristic and the whole evaluate over a
+// fixed corpus of positions. The corpus is generated by seeded self-play
+// (shallow searches with occasional random moves), or read with --corpus
+// from a file in the one-line format of --analyze; --save writes the
+// generated corpus in that format. Each benchmark runs one warm-up pass and
+// --repeat timed passes over the corpus, and the time per call is reported
+// as the median, 10th and 90th percentile and minimum over the passes.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include "analysis.hpp"
+
+struct feature {
+    std::string name;
+    std::function<int(othelloHeuristic &, othelloBoard &, int)> call;
+};
+
+/**
+ * @brief 通过自对弈生成局面集
+ *
+ * 双方以一层搜索走棋，并以一定概率随机走棋以增加多样性；记录每一步之前的局面。
+ *
+ * @param count 局面数量
+ * @param seed 随机数种子
+ * @param corpus 写入生成的局面
+ */
+void generateCorpus(size_t count, unsigned seed,
+        std::vector<analysisTask> &corpus) {
+    std::mt19937 rng(seed);
+
+    othelloPlayer players[2];
+    for (othelloPlayer &player : players) {
+        player.computer = true;
+        player.seed(seed);
+    }
+    players[0].color = 1;
+    players[1].color = -1;
+
+    searchLimits limits;
+    limits.depth = 1;
+
+    while (corpus.size() < count) {
+        othelloBoard board;
+        board.startPosition();
+        int toMove = 1;
+        bool passed = false;
+
+        while (corpus.size() < count) {
+            board.findLegalMoves(toMove, &board.moves);
+            if (board.moves.empty()) {
+                if (passed) {
+                    break;
+                }
+                passed = true;
+                toMove = -toMove;
+                continue;
+            }
+            passed = false;
+
+            analysisTask task;
+            task.id = std::to_string(corpus.size());
+            task.board = board;
+            task.board.moves.clear();
+            task.toMove = toMove;
+            corpus.push_back(task);
+
+            int square;
+            if (rng() % 5 == 0) {
+                auto it = board.moves.begin();
+                std::advance(it, rng() % board.moves.size());
+                square = it->first;
+            }
+            else {
+                othelloBoard root = board;
+                square = players[toMove == 1 ? 0 : 1].analyze(root,
+                        limits).move;
+            }
+
+            board.updateBoard(toMove, *board.moves.find(square));
+            board.discsOnBoard++;
+            toMove = -toMove;
+        }
+    }
+}
+
+bool saveCorpus(const std::string &fileName,
+        const std::vector<analysisTask> &corpus) {
+    std::ofstream ofs(fileName.c_str());
+    if (!ofs.good()) {
+        return false;
+    }
+
+    for (const analysisTask &task : corpus) {
+        for (int square : task.board.positions) {
+            ofs << (square == 1 ? 'X' : square == -1 ? 'O' : '-');
+        }
+        ofs << (task.toMove == 1 ? " X" : " O") << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief 对一个特征计时
+ *
+ * @param f 被测特征
+ * @param corpus 局面集
+ * @param repeat 计时轮数（另有一轮预热）
+ * @return 每轮中每次调用的平均耗时（纳秒），已排序
+ */
+std::vector<double> timeFeature(const feature &f,
+        std::vector<analysisTask> &corpus, int repeat) {
+    othelloHeuristic heuristic;
+    std::vector<double> samples;
+    // Keeps the calls from being optimised away
+    volatile long long sink = 0;
+
+    for (int pass = 0; pass <= repeat; pass++) {
+        long long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (analysisTask &task : corpus) {
+            sum += f.call(heuristic, task.board, task.toMove);
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        sink += sum;
+
+        // The first pass warms up caches and allocations
+        if (pass > 0) {
+            samples.push_back(elapsed.count() / corpus.size());
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples;
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double> &samples, double p) {
+    size_t rank = (size_t) std::ceil(p / 100 * samples.size());
+    return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+}
+
+int main(int argc, char **argv) {
+    size_t count = 20000;
+    unsigned seed = 1;
+    int repeat = 15;
+    std::string corpusFile, saveFile;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--positions") {
+                count = std::stoul(value);
+            }
+            else if (arg == "--seed") {
+                seed = std::stoul(value);
+            }
+            else if (arg == "--repeat") {
+                repeat = std::stoi(value);
+            }
+            else if (arg == "--corpus") {
+                corpusFile = value;
+            }
+            else if (arg == "--save") {
+                saveFile = value;
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+    repeat = std::max(repeat, 1);
+
+    std::vector<analysisTask> corpus;
+    if (!corpusFile.empty()) {
+        std::string error;
+        if (!readPositions(corpusFile, searchLimits(), corpus, error)) {
+            std::cout << error << std::endl;
+            return 1;
+        }
+    }
+    else {
+        generateCorpus(count, seed, corpus);
+    }
+    if (corpus.empty()) {
+        std::cout << "No positions!" << std::endl;
+        return 1;
+    }
+    if (!saveFile.empty() && !saveCorpus(saveFile, corpus)) {
+        std::cout << "Could not write " << saveFile << std::endl;
+        return 1;
+    }
+
+    std::vector<feature> features = {
+        {"(call)", [](othelloHeuristic &, othelloBoard &board, int) {
+            return board.discsOnBoard; }},
+        {"utility", [](othelloHeuristic &h, othelloBoard &board, int color) {
+            return h.utility(board, color); }},
+        {"discDifference", [](othelloHeuristic &h, othelloBoard &board,
+                int color) { return h.discDifference(board, color); }},
+        {"mobility", [](othelloHeuristic &h, othelloBoard &board, int color) {
+            return h.mobility(board, color); }},
+        {"potentialMobility", [](othelloHeuristic &h, othelloBoard &board,
+                int color) { return h.potentialMobility(board, color); }},
+        {"stability", [](othelloHeuristic &h, othelloBoard &board, int color) {
+            return h.stability(board, color); }},
+        {"parity", [](othelloHeuristic &h, othelloBoard &board, int) {
+            return h.parity(board); }},
+        {"squareWeights", [](othelloHeuristic &h, othelloBoard &board,
+                int color) { return h.squareWeights(board, color); }},
+        {"corners", [](othelloHeuristic &h, othelloBoard &board, int color) {
+            return h.corners(board, color); }},
+        {"evaluate", [](othelloHeuristic &h, othelloBoard &board, int color) {
+            return h.evaluate(board, color); }}
+    };
+
+    std::cout << corpus.size() << " positions, " << repeat
+        << " timed passes per feature (ns per call)" << std::endl;
+    std::cout << std::left << std::setw(20) << "feature" << std::right
+        << std::setw(10) << "median" << std::setw(10) << "p10"
+        << std::setw(10) << "p90" << std::setw(10) << "min"
+        << std::setw(11) << "of eval" << std::endl;
+
+    std::vector<std::vector<double>> samples;
+    for (const feature &f : features) {
+        samples.push_back(timeFeature(f, corpus, repeat));
+    }
+
+    double evaluateMedian = percentile(samples.back(), 50);
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < features.size(); i++) {
+        double median = percentile(samples[i], 50);
+        std::cout << std::left << std::setw(20) << features[i].name
+            << std::right << std::setw(10) << median
+            << std::setw(10) << percentile(samples[i], 10)
+            << std::setw(10) << percentile(samples[i], 90)
+            << std::setw(10) << samples[i].front()
+            << std::setw(10) << 100*median / evaluateMedian << "%"
+            << std::endl;
+    }
+
+    return 0;
+}
@@ -5,12 +5,12 @@
  * @brief 构造函数
  *
  * 初始化国际象棋游戏棋盘。
- * 将棋盘大小设置为64个位置，并将所有位置初始化为0。
+ * 将棋盘大小设置为boardSquares个位置，并将所有位置初始化为0。
  */
 othelloGame::othelloGame() {
     // 初始化棋盘，将棋盘上的所有位置都初始化为0
     // 0代表该位置为空
-    this->board.positions.resize(64, 0);
+    this->board.positions.resize(boardSquares, 0);
 }
 
 // Initialize new game
@@ -27,12 +27,7 @@ void othelloGame::newGame(bool blackComputer, bool whiteComputer,
         float timeLimit) {
     // 初始化棋盘
     // Initialize board
-    std::vector<int> setup(64, 0);
-    setup[27] = -1;
-    setup[28] = 1;
-    setup[35] = 1;
-    setup[36] = -1;
-    this->board.positions.swap(setup);
+    this->board.startPosition();
 
     // 初始化玩家
     // Initialize players
@@ -69,15 +64,49 @@ void othelloGame::loadGame(std::string fileName, bool blackComputer,
         return;
     }
 
+    // Initialize players
+    this->blackPlayer.color = 1;
+    this->blackPlayer.computer = blackComputer;
+    this->whitePlayer.color = -1;
+    this->whitePlayer.computer = whiteComputer;
+
+    std::string error;
+    if (!parseSaveFile(ifs, this->board, this->toMove, error)) {
+        std::cout << error << std::endl;
+    }
+
+    ifs.close();
+}
+
+// Parse a save file into a board and player to move
+/**
+ * @brief 解析存档格式
+ *
+ * 读取 boardSide 行棋盘、轮到的一方与时间限制，不向终端输出任何内容，
+ * 因此也可用于批量分析等无交互场景。
+ *
+ * @param ifs 存档输入流
+ * @param board 写入棋盘布局、棋子数与时间限制
+ * @param toMove 写入轮到的一方，1 表示黑方，-1 表示白方
+ * @param error 解析失败时写入错误信息
+ * @return 解析成功时返回 true
+ */
+bool othelloGame::parseSaveFile(std::istream &ifs, othelloBoard &board,
+        int &toMove, std::string &error) {
     // Load board
-    std::vector<int> setup(64, 0);
+    std::vector<int> setup(boardSquares, 0);
     std::string str;
     char ch;
     int idx = 0;
 
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < boardSide; i++) {
         std::getline(ifs, str);
-        for (int j = 0; j < 16; j += 2) {
+        if ((int) str.length() < 2*boardSide - 1) {
+            error = "Invalid file format! Refer to the README.";
+            return false;
+        }
+
+        for (int j = 0; j < 2*boardSide; j += 2) {
             ch = str[j];
             if (ch == '1') {
                 setup[idx] = 1;
@@ -89,65 +118,51 @@ void othelloGame::loadGame(std::string fileName, bool blackComputer,
                 setup[idx] = 0;
             }
             else {
-                std::cout << "Invalid file format! Refer to the README." << std::endl;
-                return;
+                error = "Invalid file format! Refer to the README.";
+                return false;
             }
 
             idx++;
         }
     }
-    this->board.discsOnBoard = 64 - std::count(setup.begin(), setup.end(), 0);
-    this->board.positions.swap(setup);
-
-    // Initialize players
-    this->blackPlayer.color = 1;
-    this->blackPlayer.computer = blackComputer;
-    this->whitePlayer.color = -1;
-    this->whitePlayer.computer = whiteComputer;
+    board.discsOnBoard = boardSquares - std::count(setup.begin(), setup.end(), 0);
+    board.positions.swap(setup);
 
     // Load player to move
     if (std::getline(ifs, str)) {
         ch = str[0];
         if (ch == '1') {
-            this->toMove = 1;
+            toMove = 1;
         }
         else if (ch == '2') {
-            this->toMove = -1;
+            toMove = -1;
         }
         else {
-            std::cout << "Player to move must be 1 (black) or 2 (white)!"
-                << std::endl;
-            ifs.close();
-            return;
+            error = "Player to move must be 1 (black) or 2 (white)!";
+            return false;
         }
     }
     else {
-        std::cout << "Save file does not specify player to move!"
-            << std::endl;
-        ifs.close();
-        return;
+        error = "Save file does not specify player to move!";
+        return false;
     }
 
     // Load time limit
     if (std::getline(ifs, str)) {
         if (stof(str) > 0) {
-            this->board.timeLimit = stof(str);
+            board.timeLimit = stof(str);
         }
         else {
-            std::cout << "Time limit must be a positive number!"
-                << std::endl;
-            ifs.close();
-            return;
+            error = "Time limit must be a positive number!";
+            return false;
         }
     }
     else {
-        std::cout << "Save file does not specify computer time limit!"
-            << std::endl;
-        ifs.close();
-        return;
+        error = "Save file does not specify computer time limit!";
+        return false;
     }
 
-    ifs.close();
+    return true;
 }
 
 // Make a move
@@ -165,14 +180,18 @@ void othelloGame::move(int color) {
     // 判断当前轮到哪方玩家下棋
     if (color == 1) {
         // 如果是黑方下棋
-        std::cout << "Black to move" << std::endl;
+        if (this->verbose) {
+            std::cout << "Black to move" << std::endl;
+        }
         // 调用黑方玩家的move方法，获取移动结果
         move = this->blackPlayer.move(this->board, this->board.moves,
                 this->board.passes[0], this->moveHistory);
     } 
     else if (color == -1) {
         // 如果是白方下棋
-        std::cout << "White to move" << std::endl;
+        if (this->verbose) {
+            std::cout << "White to move" << std::endl;
+        }
         // 调用白方玩家的move方法，获取移动结果
         move = this->whitePlayer.move(this->board, this->board.moves,
                 this->board.passes[0], this->moveHistory);
@@ -205,22 +224,24 @@ void othelloGame::checkGameOver() {
         int whiteCount = std::count(this->board.positions.begin(),
                 this->board.positions.end(), -1);
 
-        // 显示棋盘
-        this->board.displayBoard(1);
+        if (this->verbose) {
+            // 显示棋盘
+            this->board.displayBoard(1);
 
-        // 判断胜负
-        if (blackCount > whiteCount) {
-            std::cout << "Black wins!" << std::endl;
-        }
-        else if (blackCount < whiteCount) {
-            std::cout << "White wins!" << std::endl;
-        }
-        else {
-            std::cout << "Tie!" << std::endl;
+            // 判断胜负
+            if (blackCount > whiteCount) {
+                std::cout << "Black wins!" << std::endl;
+            }
+            else if (blackCount < whiteCount) {
+                std::cout << "White wins!" << std::endl;
+            }
+            else {
+                std::cout << "Tie!" << std::endl;
+            }
+            // 输出双方棋子的数量
+            std::cout << "Black: " << blackCount << "\t"
+                << "White: " << whiteCount << std::endl;
         }
-        // 输出双方棋子的数量
-        std::cout << "Black: " << blackCount << "\t"
-            << "White: " << whiteCount << std::endl;
 
         // 设置游戏结束标志为true
         this->gameOver = true;
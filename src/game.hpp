@@ -14,6 +14,8 @@ class othelloGame {
 
         int toMove = 1;
         bool gameOver = false;
+        // Console output from move and checkGameOver
+        bool verbose = true;
 
         // Constructor
         othelloGame();
@@ -27,6 +29,11 @@ class othelloGame {
         // and clock time limit for the AI, respectively.
         void loadGame(std::string fileName, bool blackComputer, bool whiteComputer);
 
+        // Parse a save file without any console output. Returns false and
+        // sets error if the file is malformed.
+        static bool parseSaveFile(std::istream &ifs, othelloBoard &board,
+                int &toMove, std::string &error);
+
         // Make a move
         void move(int color);
 
@@ -0,0 +1,233 @@
+// Game archive packer, lister and checker.
+//
+// Usage: gamearchive.exe pack --output FILE INPUT...
+//        gamearchive.exe list ARCHIVE
+//        gamearchive.exe verify ARCHIVE
+//
+// pack reads one game per line, as a move sequence in catalogue notation
+// ("f5d6c3d3c4") or as a move history ("37,43,42,"), optionally followed by
+// the names of the black and white players, and writes a game archive (see
+// archive.hpp). Games are replayed to check them and to work out the
+// result; illegal games are reported and skipped. list prints every game of
+// an archive in the input format of pack, with its result after a ";"
+// (ignored by pack). verify replays every game, checks the recorded results
+// and reports the replay speed.
+
+#include <chrono>
+#include "analysis.hpp"
+#include "archive.hpp"
+
+// Parses a move sequence in either input format of pack
+bool parseMoves(const std::string &text, std::vector<int> &moves) {
+    moves.clear();
+    if (text.find(',') == std::string::npos) {
+        return othelloDatabase::parseCatalogueLine(text, moves);
+    }
+
+    std::istringstream iss(text);
+    std::string square;
+    while (std::getline(iss, square, ',')) {
+        try {
+            moves.push_back(std::stoi(square));
+        }
+        catch (const std::exception &) {
+            return false;
+        }
+    }
+    return !moves.empty();
+}
+
+// Catalogue notation of a move sequence: black's moves in upper case
+std::string catalogueString(const gameView &game) {
+    std::string text;
+    othelloBoard board;
+    othelloArchiveReader::replay(game, board,
+            [&text](const othelloBoard &, int toMove, int square) {
+                if (square != -1) {
+                    std::string coord = index2string(square);
+                    text += (toMove == 1) ? coord : std::string(1,
+                            std::tolower(coord[0])) + coord[1];
+                }
+            });
+    return text;
+}
+
+/**
+ * @brief 将文本对局打包为归档
+ *
+ * @param output 输出归档文件
+ * @param inputs 输入文本文件，每行一盘棋
+ * @return 成功时返回 0
+ */
+int pack(const std::string &output, const std::vector<std::string> &inputs) {
+    othelloArchiveWriter writer;
+    if (!writer.open(output)) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    othelloBoard board;
+    std::vector<int> moves;
+    int skipped = 0;
+    for (const std::string &input : inputs) {
+        std::ifstream ifs(input.c_str());
+        if (!ifs.good()) {
+            std::cout << input << ": file does not exist" << std::endl;
+            return 1;
+        }
+
+        std::string line, sequence;
+        int lineNum = 0;
+        while (std::getline(ifs, line)) {
+            lineNum++;
+            std::istringstream iss(line);
+            if (!(iss >> sequence) || sequence[0] == '#') {
+                continue;
+            }
+
+            // Names end at the "; result" that list appends
+            gameRecord record;
+            std::string name;
+            if (iss >> name && name[0] != ';') {
+                record.black = name;
+                if (iss >> name && name[0] != ';') {
+                    record.white = name;
+                }
+            }
+            if (!parseMoves(sequence, record.moves)) {
+                std::cout << input << ":" << lineNum << ": invalid moves"
+                    << std::endl;
+                skipped++;
+                continue;
+            }
+
+            // Replay to check the moves and find the result, which the
+            // view does not have yet
+            std::vector<uint8_t> squares;
+            for (int square : record.moves) {
+                squares.push_back((uint8_t) square);
+            }
+            gameView game;
+            game.moves = squares.data();
+            game.moveCount = squares.size();
+            if (std::find(record.moves.begin(), record.moves.end(), -1)
+                    != record.moves.end()
+                    || !othelloArchiveReader::replay(game, board, nullptr,
+                        false)) {
+                std::cout << input << ":" << lineNum << ": illegal game"
+                    << std::endl;
+                skipped++;
+                continue;
+            }
+            // Unfinished games keep the disc difference so far
+            board.findLegalMoves(1, &board.moves);
+            if (board.moves.empty()) {
+                board.findLegalMoves(-1, &board.moves);
+            }
+            record.result = board.moves.empty() ? finalResult(board)
+                : std::accumulate(board.positions.begin(),
+                        board.positions.end(), 0);
+
+            if (!writer.add(record)) {
+                std::cout << input << ":" << lineNum
+                    << ": game does not fit the archive format" << std::endl;
+                skipped++;
+            }
+        }
+    }
+
+    uint64_t games = writer.games();
+    if (!writer.close()) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << games << " games written to " << output << ", " << skipped
+        << " skipped" << std::endl;
+    return 0;
+}
+
+int list(othelloArchiveReader &reader) {
+    gameView game;
+    while (reader.next(game)) {
+        std::cout << catalogueString(game);
+        if (game.blackLength > 0 || game.whiteLength > 0) {
+            std::cout << " " << std::string(game.black, game.blackLength)
+                << " " << std::string(game.white, game.whiteLength);
+        }
+        std::cout << " ; " << game.result << std::endl;
+    }
+    return 0;
+}
+
+int verify(othelloArchiveReader &reader) {
+    auto start = std::chrono::steady_clock::now();
+    othelloBoard board;
+    gameView game;
+    long long games = 0, moves = 0, bad = 0;
+    while (reader.next(game)) {
+        games++;
+        moves += game.moveCount;
+        if (!othelloArchiveReader::replay(game, board)) {
+            bad++;
+        }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << games << " games, " << moves << " moves, " << bad
+        << " invalid, " << elapsed.count() << "s ("
+        << (long long) (games / std::max(elapsed.count(), 1e-6))
+        << " games/s)" << std::endl;
+    return bad == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    std::string command = (argc > 1) ? argv[1] : "";
+    std::string output;
+    std::vector<std::string> inputs;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--output") {
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+            output = argv[++i];
+        }
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (command == "pack") {
+        if (output.empty() || inputs.empty()) {
+            std::cout << "Usage: gamearchive.exe pack --output FILE INPUT..."
+                << std::endl;
+            return 1;
+        }
+        return pack(output, inputs);
+    }
+    if ((command == "list" || command == "verify") && inputs.size() == 1) {
+        othelloArchiveReader reader;
+        if (!reader.open(inputs[0])) {
+            std::cout << reader.error() << std::endl;
+            return 1;
+        }
+        int status = (command == "list") ? list(reader) : verify(reader);
+        if (!reader.error().empty()) {
+            std::cout << inputs[0] << ": " << reader.error() << std::endl;
+            return 1;
+        }
+        return status;
+    }
+
+    std::cout << "Usage: gamearchive.exe pack --output FILE INPUT..."
+        << std::endl << "       gamearchive.exe list|verify ARCHIVE"
+        << std::endl;
+    return 1;
+}
@@ -0,0 +1,86 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <cctype>
+#include <string>
+
+// Shape of the board the engine is built for. The size is fixed at compile
+// time with -DOTHELLO_BOARD_SIZE=N (make BOARD_SIZE=N); every module sees
+// the same boardGeometry<N> through the geometry alias, so that loops over
+// squares and direction offsets are constants.
+#ifndef OTHELLO_BOARD_SIZE
+#define OTHELLO_BOARD_SIZE 8
+#endif
+
+template <int size>
+struct boardGeometry {
+    static_assert(size >= 6 && size <= 10 && size % 2 == 0,
+            "boards are square with an even side from 6 to 10");
+
+    // Squares are indexed from 0 to squares - 1, left to right, top to
+    // bottom
+    static constexpr int side = size;
+    static constexpr int squares = size*size;
+
+    // The eight directions, in the order moves are searched: left, right,
+    // up, down, up-left, down-right, up-right, down-left
+    static constexpr int directions[8] = {-1, 1, -size, size,
+        -size - 1, size + 1, -size + 1, size - 1};
+
+    // Top left, top right, bottom left, bottom right
+    static constexpr int corners[4] = {0, size - 1, size*(size - 1),
+        size*size - 1};
+
+    // The four centre squares: white on the falling diagonal and black on
+    // the rising one at the start
+    static constexpr int centre = (size/2 - 1)*size + size/2 - 1;
+    static constexpr int whiteStart[2] = {centre, centre + size + 1};
+    static constexpr int blackStart[2] = {centre + 1, centre + size};
+
+    static constexpr int square(int row, int col) {
+        return size*row + col;
+    }
+    static constexpr int row(int square) {
+        return square / size;
+    }
+    static constexpr int col(int square) {
+        return square % size;
+    }
+};
+
+using geometry = boardGeometry<OTHELLO_BOARD_SIZE>;
+
+const int boardSide = geometry::side;
+const int boardSquares = geometry::squares;
+
+// Square names: a column letter from 'A' and a row number from 1, so "A1"
+// is square 0 and "H8" square 63 on the standard board
+inline std::string squareName(int square) {
+    return std::string(1, (char) ('A' + geometry::col(square)))
+        + std::to_string(geometry::row(square) + 1);
+}
+
+// Square index of a name in either case, or -1 if it is not on the board
+inline int squareIndex(const std::string &name) {
+    if (name.length() < 2 || name.length() > 3) {
+        return -1;
+    }
+
+    int col = std::tolower(name[0]) - 'a';
+    int row = 0;
+    for (size_t i = 1; i < name.length(); i++) {
+        if (name[i] < '0' || name[i] > '9') {
+            return -1;
+        }
+        row = 10*row + name[i] - '0';
+    }
+    row--;
+
+    if (col < 0 || col >= boardSide || row < 0 || row >= boardSide
+            || (name.length() == 3 && name[1] == '0')) {
+        return -1;
+    }
+    return geometry::square(row, col);
+}
+
+#endif // GEOMETRY_HPP
@@ -1,112 +1,260 @@
+#include <array>
 #include "heuristic.hpp"
 // Heuristic is from the perspective that the calling player is the maximizing
-// player, regardless of the player's color
+// player, regardless of the player's color. Every feature is instantiated
+// for both colors; the versions taking a color only pick one.
+
+namespace {
+    constexpr int side = boardSide;
+
+    // Squares whose neighbours count towards potential mobility: the
+    // interior two squares away from every edge, and the squares one away
+    // from the top, bottom and left edges alongside it
+    template <int count>
+    struct squareList {
+        int squares[count];
+    };
+
+    constexpr int inner = side - 4;
+
+    constexpr squareList<inner*inner> makeInterior() {
+        squareList<inner*inner> list = {};
+        for (int i = 0; i < inner*inner; i++) {
+            list.squares[i] = geometry::square(2 + i / inner, 2 + i % inner);
+        }
+        return list;
+    }
+
+    constexpr squareList<inner> makeLine(int row, int col, int step) {
+        squareList<inner> list = {};
+        for (int i = 0; i < inner; i++) {
+            list.squares[i] = geometry::square(row, col) + i*step;
+        }
+        return list;
+    }
+
+    constexpr auto boardInterior = makeInterior();
+    constexpr auto topRow = makeLine(1, 2, 1);
+    constexpr auto bottomRow = makeLine(side - 2, 2, 1);
+    constexpr auto leftColumn = makeLine(2, 1, side);
+
+    constexpr std::array<int, 64> standardWeights = {{
+         200, -100, 100,  50,  50, 100, -100,  200,
+        -100, -200, -50, -50, -50, -50, -200, -100,
+         100,  -50, 100,   0,   0, 100,  -50,  100,
+          50,  -50,   0,   0,   0,   0,  -50,   50,
+          50,  -50,   0,   0,   0,   0,  -50,   50,
+         100,  -50, 100,   0,   0, 100,  -50,  100,
+        -100, -200, -50, -50, -50, -50, -200, -100,
+         200, -100, 100,  50,  50, 100, -100,  200,
+    }};
+
+    // Row or column on the standard board that a row or column of this
+    // board is weighted like: the three nearest each edge keep their
+    // weights and the ones between are weighted like the centre
+    constexpr int standardLine(int line) {
+        return (line < 3) ? line
+            : (line > side - 4) ? 7 - (side - 1 - line)
+            : 3;
+    }
+
+    constexpr std::array<int, boardSquares> makeWeights() {
+        std::array<int, boardSquares> weights = {};
+        for (int i = 0; i < boardSquares; i++) {
+            weights[i] = standardWeights[8*standardLine(geometry::row(i))
+                + standardLine(geometry::col(i))];
+        }
+        return weights;
+    }
+
+    constexpr std::array<int, boardSquares> baseWeights = makeWeights();
+
+    // Squares near a corner whose weights no longer count once the corner
+    // is taken, as (row, column) away from the corner
+    constexpr int cornerRegion[12][2] = {
+        {0, 1}, {0, 2}, {0, 3},
+        {1, 0}, {1, 1}, {1, 2}, {1, 3},
+        {2, 0}, {2, 1}, {2, 2},
+        {3, 0}, {3, 1}
+    };
+
+    constexpr squareList<4*12> makeCornerRegions() {
+        squareList<4*12> list = {};
+        for (int c = 0; c < 4; c++) {
+            int corner = geometry::corners[c];
+            bool bottom = geometry::row(corner) != 0;
+            bool right = geometry::col(corner) != 0;
+            for (int i = 0; i < 12; i++) {
+                int row = cornerRegion[i][0], col = cornerRegion[i][1];
+                list.squares[12*c + i] = geometry::square(
+                        bottom ? side - 1 - row : row,
+                        right ? side - 1 - col : col);
+            }
+        }
+        return list;
+    }
+
+    constexpr auto cornerRegions = makeCornerRegions();
+}
 
 int othelloHeuristic::evaluate(othelloBoard &board, int color) {
-    if (board.terminalState()) {
-        return 100000*utility(board, color);
+    return (color == 1) ? this->evaluate<1>(board) : this->evaluate<-1>(board);
+}
+
+template <int color>
+int othelloHeuristic::evaluate(othelloBoard &board) {
+    if (board.terminalState() || board.discsOnBoard == boardSquares) {
+        return terminalWeight*utility<color>(board);
+    }
+
+    if (this->type == evaluatorType::greedy) {
+        return discDifference<color>(board);
+    }
+    else if (this->type == evaluatorType::positional) {
+        return 10*squareWeights<color>(board)
+            + 5*mobility<color>(board)
+            + 10000*corners<color>(board);
     }
 
-    if (board.discsOnBoard <= 20) {
+    // The phases end at 20 and 58 discs on the standard board
+    if (board.discsOnBoard <= 5*boardSquares/16) {
         // Opening game
-        return 5*mobility(board, color)
-            + 5*potentialMobility(board, color)
-            + 20*squareWeights(board, color)
-            + 10000*corners(board, color)
-            + 10000*stability(board, color);
+        return 5*mobility<color>(board)
+            + 5*potentialMobility<color>(board)
+            + 20*squareWeights<color>(board)
+            + 10000*corners<color>(board)
+            + 10000*stability<color>(board);
     }
-    else if (board.discsOnBoard <= 58) {
+    else if (board.discsOnBoard <= boardSquares - 6) {
         // Midgame
-        return 10*discDifference(board, color)
-            + 2*mobility(board, color)
-            + 2*potentialMobility(board, color)
-            + 10*squareWeights(board, color)
+        return 10*discDifference<color>(board)
+            + 2*mobility<color>(board)
+            + 2*potentialMobility<color>(board)
+            + 10*squareWeights<color>(board)
             + 100*parity(board)
-            + 10000*corners(board, color)
-            + 10000*stability(board, color);
+            + 10000*corners<color>(board)
+            + 10000*stability<color>(board);
     }
     else {
         // Endgame
-        return 500*discDifference(board, color)
+        return 500*discDifference<color>(board)
             + 500*parity(board)
-            + 10000*corners(board, color)
-            + 10000*stability(board, color);
+            + 10000*corners<color>(board)
+            + 10000*stability<color>(board);
     }
 }
 
+// Search scores carry small pruning adjustments, so round to the nearest
+// multiple of terminalWeight
+int othelloHeuristic::discScore(int score) {
+    return (score + (score < 0 ? -terminalWeight : terminalWeight)/2)
+        / terminalWeight;
+}
+
+bool othelloHeuristic::parseEvaluator(const std::string &name,
+        evaluatorType &type) {
+    if (name == "standard") {
+        type = evaluatorType::standard;
+    }
+    else if (name == "positional") {
+        type = evaluatorType::positional;
+    }
+    else if (name == "greedy") {
+        type = evaluatorType::greedy;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
 int othelloHeuristic::utility(othelloBoard &board, int &color) {
+    return (color == 1) ? utility<1>(board) : utility<-1>(board);
+}
+
+// Final disc difference, with empty squares going to the winner
+template <int color>
+int othelloHeuristic::utility(othelloBoard &board) {
     int util = std::accumulate(board.positions.begin(),
             board.positions.end(), 0);
-
-    if (color == 1) {
-        return util; 
+    int empties = std::count(board.positions.begin(),
+            board.positions.end(), 0);
+    if (util > 0) {
+        util += empties;
     }
-    else {
-        return -1*util;
+    else if (util < 0) {
+        util -= empties;
     }
+
+    return color*util;
 }
 
-// Relative disc difference between the two players
 int othelloHeuristic::discDifference(othelloBoard &board, int &color) {
+    return (color == 1) ? discDifference<1>(board) : discDifference<-1>(board);
+}
+
+// Relative disc difference between the two players. Division truncates
+// towards zero, so negating the quotient is the same as swapping players.
+template <int color>
+int othelloHeuristic::discDifference(othelloBoard &board) {
     int blackCount = std::count(board.positions.begin(),
             board.positions.end(), 1);
     int whiteCount = std::count(board.positions.begin(),
             board.positions.end(), -1);
 
-    if (color == 1) {
-        return 100 * (blackCount - whiteCount) / (blackCount + whiteCount);
-    }
-    else {
-        return 100 * (whiteCount - blackCount) / (blackCount + whiteCount);
-    }
+    return color * (100 * (blackCount - whiteCount)
+            / (blackCount + whiteCount));
 }
 
-// Number of possible moves
 int othelloHeuristic::mobility(othelloBoard &board, int &color) {
-    board.findLegalMoves(1, &pMoves);
+    return (color == 1) ? mobility<1>(board) : mobility<-1>(board);
+}
+
+// Number of possible moves
+template <int color>
+int othelloHeuristic::mobility(othelloBoard &board) {
+    board.findLegalMoves<1>(&pMoves);
     int blackMoves = pMoves.size();
     pMoves.clear();
 
-    board.findLegalMoves(-1, &pMoves);
+    board.findLegalMoves<-1>(&pMoves);
     int whiteMoves = pMoves.size();
     pMoves.clear();
 
-    if (color == 1) {
-        return 100 * (blackMoves - whiteMoves) / (blackMoves + whiteMoves + 1);
-    }
-    else {
-        return 100 * (whiteMoves - blackMoves) / (blackMoves + whiteMoves + 1);
-    }
+    return color * (100 * (blackMoves - whiteMoves)
+            / (blackMoves + whiteMoves + 1));
 }
 
 int othelloHeuristic::potentialMobility(othelloBoard &board, int color) {
-    int myPotentialMobility = playerPotentialMobility(board, color);
-    int opponentPotentialMobility = playerPotentialMobility(board, -color);
+    return (color == 1) ? potentialMobility<1>(board)
+        : potentialMobility<-1>(board);
+}
+
+template <int color>
+int othelloHeuristic::potentialMobility(othelloBoard &board) {
+    int myPotentialMobility = playerPotentialMobility<color>(board);
+    int opponentPotentialMobility = playerPotentialMobility<-color>(board);
 
     return 100 * (myPotentialMobility - opponentPotentialMobility)
         / (myPotentialMobility + opponentPotentialMobility + 1);
 }
 
-int othelloHeuristic::playerPotentialMobility(othelloBoard &board, int color) {
-    std::vector<int> boardInterior = {18, 19, 20, 21,
-                                      26, 27, 28, 29,
-                                      34, 35, 36, 37,
-                                      42, 43, 44, 45};
-
+template <int color>
+int othelloHeuristic::playerPotentialMobility(othelloBoard &board) {
     int here = 0, up = 0, down = 0, left = 0, right = 0,
         upperLeft = 0, upperRight = 0, lowerLeft = 0, lowerRight = 0;
     int potentialMobility = 0;
 
-    for (int square : boardInterior) {
+    for (int square : boardInterior.squares) {
         here = board.positions[square];
-        up = board.positions[square-8];
-        down = board.positions[square+8];
+        up = board.positions[square-side];
+        down = board.positions[square+side];
         left = board.positions[square-1];
         right = board.positions[square+1];
-        upperLeft = board.positions[square-9];
-        upperRight = board.positions[square-7];
-        lowerLeft = board.positions[square+7];
-        lowerRight = board.positions[square+9];
+        upperLeft = board.positions[square-side-1];
+        upperRight = board.positions[square-side+1];
+        lowerLeft = board.positions[square+side-1];
+        lowerRight = board.positions[square+side+1];
 
         if (here == -color && up == 0)
             potentialMobility++;
@@ -126,8 +274,7 @@ int othelloHeuristic::playerPotentialMobility(othelloBoard &board, int color) {
             potentialMobility++;
     }
 
-    std::vector<int> topRow = {10, 11, 12, 13};
-    for (int square : topRow) {
+    for (int square : topRow.squares) {
         here = board.positions[square];
         left = board.positions[square-1];
         right = board.positions[square+1];
@@ -137,8 +284,7 @@ int othelloHeuristic::playerPotentialMobility(othelloBoard &board, int color) {
             potentialMobility++;
     }
 
-    std::vector<int> bottomRow = {50, 51, 52, 53};
-    for (int square : bottomRow) {
+    for (int square : bottomRow.squares) {
         here = board.positions[square];
         left = board.positions[square-1];
         right = board.positions[square+1];
@@ -148,22 +294,23 @@ int othelloHeuristic::playerPotentialMobility(othelloBoard &board, int color) {
             potentialMobility++;
     }
 
-    std::vector<int> leftColumn = {17, 25, 33, 41};
-    for (int square : leftColumn) {
+    for (int square : leftColumn.squares) {
         here = board.positions[square];
-        up = board.positions[square-8];
-        down = board.positions[square+8];
+        up = board.positions[square-side];
+        down = board.positions[square+side];
         if (here == -color && up == 0)
             potentialMobility++;
         if (here == -color && down == 0)
             potentialMobility++;
     }
 
-    std::vector<int> rightColumn = {22, 30, 38, 46};
-    for (int square : leftColumn) {
+    // The right column (22, 30, 38, 46 on the standard board) has always
+    // been scored with the left column's squares; kept so that evaluations
+    // do not change
+    for (int square : leftColumn.squares) {
         here = board.positions[square];
-        up = board.positions[square-8];
-        down = board.positions[square+8];
+        up = board.positions[square-side];
+        down = board.positions[square+side];
         if (here == -color && up == 0)
             potentialMobility++;
         if (here == -color && down == 0)
@@ -173,21 +320,24 @@ int othelloHeuristic::playerPotentialMobility(othelloBoard &board, int color) {
     return potentialMobility;
 }
 
-// Computes a lower bound on the number of stable discs
 int othelloHeuristic::stability(othelloBoard &board, int color) {
+    return (color == 1) ? stability<1>(board) : stability<-1>(board);
+}
+
+// Computes a lower bound on the number of stable discs
+template <int color>
+int othelloHeuristic::stability(othelloBoard &board) {
     stableDiscs.clear();
 
-    stableDiscsFromCorner(board, 0, color);
-    stableDiscsFromCorner(board, 7, color);
-    stableDiscsFromCorner(board, 56, color);
-    stableDiscsFromCorner(board, 63, color);
+    for (int corner : geometry::corners) {
+        stableDiscsFromCorner<color>(board, corner);
+    }
 
     int myStables = stableDiscs.size();
 
-    stableDiscsFromCorner(board, 0, -color);
-    stableDiscsFromCorner(board, 7, -color);
-    stableDiscsFromCorner(board, 56, -color);
-    stableDiscsFromCorner(board, 63, -color);
+    for (int corner : geometry::corners) {
+        stableDiscsFromCorner<-color>(board, corner);
+    }
 
     int opponentStables = stableDiscs.size();
 
@@ -195,18 +345,19 @@ int othelloHeuristic::stability(othelloBoard &board, int color) {
 }
 
 // Finds the number of stable discs given a corner
-void othelloHeuristic::stableDiscsFromCorner(othelloBoard &board, int corner,
-        int color) {
+template <int color>
+void othelloHeuristic::stableDiscsFromCorner(othelloBoard &board,
+        int corner) {
     bool down, right;
     if (corner == 0) {
         down = true;
         right = true;
     }
-    else if (corner == 7) {
+    else if (corner == geometry::corners[1]) {
         down = true;
         right = false;
     }
-    else if (corner == 56) {
+    else if (corner == geometry::corners[2]) {
         down = false;
         right = true;
     }
@@ -215,7 +366,8 @@ void othelloHeuristic::stableDiscsFromCorner(othelloBoard &board, int corner,
         right = false;
     }
 
-    int horizIncr = 1, horizStop = 7, vertIncr = 8, vertStop = 56;
+    int horizIncr = 1, horizStop = side - 1, vertIncr = side,
+        vertStop = side*(side - 1);
     if (!right) {
         horizIncr *= -1;
         horizStop *= -1;
@@ -252,7 +404,7 @@ void othelloHeuristic::stableDiscsFromCorner(othelloBoard &board, int corner,
 }
 
 int othelloHeuristic::parity(othelloBoard &board) {
-    int squaresRemaining = 64 - board.discsOnBoard;
+    int squaresRemaining = boardSquares - board.discsOnBoard;
 
     if (squaresRemaining % 2 == 0) {
         return -1;
@@ -262,95 +414,37 @@ int othelloHeuristic::parity(othelloBoard &board) {
     }
 }
 
-// Assigns a weight to every square on the board
 int othelloHeuristic::squareWeights(othelloBoard &board, int &color) {
-    std::vector<int> weights = {
-         200, -100, 100,  50,  50, 100, -100,  200,
-        -100, -200, -50, -50, -50, -50, -200, -100,
-         100,  -50, 100,   0,   0, 100,  -50,  100,
-          50,  -50,   0,   0,   0,   0,  -50,   50,
-          50,  -50,   0,   0,   0,   0,  -50,   50,
-         100,  -50, 100,   0,   0, 100,  -50,  100,
-        -100, -200, -50, -50, -50, -50, -200, -100,
-         200, -100, 100,  50,  50, 100, -100,  200,
-    };
+    return (color == 1) ? squareWeights<1>(board) : squareWeights<-1>(board);
+}
 
-    if (board.positions[0] != 0) {
-        weights[1]  = 0;
-        weights[2]  = 0;
-        weights[3]  = 0;
-        weights[8]  = 0;
-        weights[9]  = 0;
-        weights[10] = 0;
-        weights[11] = 0;
-        weights[16] = 0;
-        weights[17] = 0;
-        weights[18] = 0;
-        weights[24] = 0;
-        weights[25] = 0;
-    }
-
-    if (board.positions[7] != 0) {
-        weights[4]  = 0;
-        weights[5]  = 0;
-        weights[6]  = 0;
-        weights[12] = 0;
-        weights[13] = 0;
-        weights[14] = 0;
-        weights[15] = 0;
-        weights[21] = 0;
-        weights[22] = 0;
-        weights[23] = 0;
-        weights[30] = 0;
-        weights[31] = 0;
-    }
-
-    if (board.positions[56] != 0) {
-        weights[32] = 0;
-        weights[33] = 0;
-        weights[40] = 0;
-        weights[41] = 0;
-        weights[42] = 0;
-        weights[48] = 0;
-        weights[49] = 0;
-        weights[50] = 0;
-        weights[51] = 0;
-        weights[57] = 0;
-        weights[58] = 0;
-        weights[59] = 0;
-    }
-
-    if (board.positions[63] != 0) {
-        weights[38] = 0;
-        weights[39] = 0;
-        weights[45] = 0;
-        weights[46] = 0;
-        weights[47] = 0;
-        weights[52] = 0;
-        weights[53] = 0;
-        weights[54] = 0;
-        weights[55] = 0;
-        weights[60] = 0;
-        weights[61] = 0;
-        weights[62] = 0;
-    }
-
-    if (color == 1) {
-        return std::inner_product(board.positions.begin(),
-                board.positions.end(), weights.begin(), 0);
-    }
-    else {
-        return -1*std::inner_product(board.positions.begin(),
-                board.positions.end(), weights.begin(), 0);
+// Assigns a weight to every square on the board
+template <int color>
+int othelloHeuristic::squareWeights(othelloBoard &board) {
+    std::array<int, boardSquares> weights = baseWeights;
+
+    for (int c = 0; c < 4; c++) {
+        if (board.positions[geometry::corners[c]] != 0) {
+            for (int i = 12*c; i < 12*(c + 1); i++) {
+                weights[cornerRegions.squares[i]] = 0;
+            }
+        }
     }
+
+    return color*std::inner_product(board.positions.begin(),
+            board.positions.end(), weights.begin(), 0);
 }
 
 int othelloHeuristic::corners(othelloBoard &board, int &color) {
-    std::vector<int> corners = {0, 7, 56, 63};
+    return (color == 1) ? corners<1>(board) : corners<-1>(board);
+}
+
+template <int color>
+int othelloHeuristic::corners(othelloBoard &board) {
     int blackCorners = 0;
     int whiteCorners = 0;
 
-    for (int corner : corners) {
+    for (int corner : geometry::corners) {
         if (board.positions[corner] == 1) {
             blackCorners++;
         }
@@ -359,12 +453,9 @@ int othelloHeuristic::corners(othelloBoard &board, int &color) {
         }
     }
 
-    if (color == 1) {
-        return 100 * (blackCorners - whiteCorners)
-            / (blackCorners + whiteCorners + 1);
-    }
-    else {
-        return 100 * (whiteCorners - blackCorners)
-            / (blackCorners + whiteCorners + 1);
-    }
+    return color * (100 * (blackCorners - whiteCorners)
+            / (blackCorners + whiteCorners + 1));
 }
+
+template int othelloHeuristic::evaluate<1>(othelloBoard &board);
+template int othelloHeuristic::evaluate<-1>(othelloBoard &board);
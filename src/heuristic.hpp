@@ -5,25 +5,61 @@
 #include <unordered_set>
 #include "board.hpp"
 
+// Evaluation functions that can be selected per player
+enum class evaluatorType {
+    standard,       // phase-dependent combination of every feature
+    positional,     // square weights, corners and mobility
+    greedy          // disc difference only
+};
+
 class othelloHeuristic {
     public:
+        evaluatorType type = evaluatorType::standard;
+
+        // Finished games score terminalWeight times the final disc
+        // difference, so an exact endgame search can recover the result
+        static const int terminalWeight = 100000;
+
         int evaluate(othelloBoard &board, int color);
+        // The same for a color fixed at compile time (1 or -1). Every
+        // feature below has such a version, used by evaluate.
+        template <int color>
+        int evaluate(othelloBoard &board);
 
-    private:
-        std::unordered_set<int> stableDiscs;
-        std::unordered_map<int, std::list<int>> pMoves;
+        // Converts a search score back to a final disc difference
+        static int discScore(int score);
 
+        // Parses "standard", "positional" or "greedy"
+        static bool parseEvaluator(const std::string &name,
+                evaluatorType &type);
+
+        // Individual features, combined by evaluate. Public so that they
+        // can be timed separately (see evalbench.cpp).
         int utility(othelloBoard &board, int &color);
         int discDifference(othelloBoard &board, int &color);
         int mobility(othelloBoard &board, int &color);
         int potentialMobility(othelloBoard &board, int color);
-        int playerPotentialMobility(othelloBoard &board, int color);
         int stability(othelloBoard &board, int color);
-        void stableDiscsFromCorner(othelloBoard &board,
-                int corner, int color);
         int parity(othelloBoard &board);
         int squareWeights(othelloBoard &board, int &color);
         int corners(othelloBoard &board, int &color);
+
+        template <int color> int utility(othelloBoard &board);
+        template <int color> int discDifference(othelloBoard &board);
+        template <int color> int mobility(othelloBoard &board);
+        template <int color> int potentialMobility(othelloBoard &board);
+        template <int color> int stability(othelloBoard &board);
+        template <int color> int squareWeights(othelloBoard &board);
+        template <int color> int corners(othelloBoard &board);
+
+    private:
+        std::unordered_set<int> stableDiscs;
+        std::unordered_map<int, std::list<int>> pMoves;
+
+        template <int color>
+        int playerPotentialMobility(othelloBoard &board);
+        template <int color>
+        void stableDiscsFromCorner(othelloBoard &board, int corner);
 };
 
 #endif // HEURISTIC_HPP
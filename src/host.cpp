@@ -0,0 +1,254 @@
+#include "host.hpp"
+
+othelloHost::othelloHost(int threads, size_t tableBytes, long long sliceNodes)
+    : sliceNodes(std::max(sliceNodes, 1LL)), sharedTable(tableBytes),
+      pool(threads) {
+}
+
+othelloHost::~othelloHost() {
+    this->shuttingDown = true;
+    this->pool.wait();
+}
+
+int othelloHost::createGame() {
+    std::shared_ptr<hostedGame> state = std::make_shared<hostedGame>();
+    state->board.startPosition();
+    return this->addGame(state);
+}
+
+/**
+ * @brief 从给定局面开始一盘棋
+ *
+ * @param board 初始局面
+ * @param toMove 轮到的一方，1 为黑方，-1 为白方
+ * @return 新棋局的编号
+ */
+int othelloHost::createGame(const othelloBoard &board, int toMove) {
+    std::shared_ptr<hostedGame> state = std::make_shared<hostedGame>();
+    state->board.positions = board.positions;
+    state->board.discsOnBoard = std::count_if(board.positions.begin(),
+            board.positions.end(), [](int square) { return square != 0; });
+    state->toMove = toMove;
+    state->bookUsable = false;
+
+    othelloBoard check = state->board;
+    check.findLegalMoves(toMove, &check.moves);
+    if (check.moves.empty()) {
+        check.findLegalMoves(-toMove, &check.moves);
+        state->over = check.moves.empty();
+    }
+
+    return this->addGame(state);
+}
+
+int othelloHost::addGame(std::shared_ptr<hostedGame> state) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->hosted[this->nextId] = state;
+    return this->nextId++;
+}
+
+/**
+ * @brief 为轮到的一方走一步棋
+ *
+ * @param game 棋局编号
+ * @param square 落子位置，-1 表示弃权（仅在无子可下时合法）
+ * @return 走法合法且已执行时返回 true
+ */
+bool othelloHost::submitMove(int game, int square) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->hosted.find(game);
+    if (it == this->hosted.end() || it->second->searching
+            || it->second->over) {
+        return false;
+    }
+
+    hostedGame &state = *it->second;
+    state.board.findLegalMoves(state.toMove, &state.board.moves);
+    if (square == -1) {
+        if (!state.board.moves.empty()) {
+            return false;
+        }
+        state.bookUsable = false;
+    }
+    else {
+        auto move = state.board.moves.find(square);
+        if (move == state.board.moves.end()) {
+            return false;
+        }
+        state.board.updateBoard(state.toMove, *move);
+        state.board.discsOnBoard++;
+        state.moveHistory.append(std::to_string(square) + ",");
+    }
+    state.toMove = -state.toMove;
+
+    // The game is over when neither side can move
+    state.board.findLegalMoves(state.toMove, &state.board.moves);
+    if (state.board.moves.empty()) {
+        state.board.findLegalMoves(-state.toMove, &state.board.moves);
+        state.over = state.board.moves.empty();
+    }
+    state.board.moves.clear();
+    return true;
+}
+
+/**
+ * @brief 请求引擎为轮到的一方选择走法
+ *
+ * 开局库命中、只有一个合法走法或无子可下时立即回调；否则创建可恢复搜索，
+ * 以截止时间为优先级分片提交到线程池，截止时间早的棋局先搜索。
+ * 截止时间到达、达到深度或搜索完成时回调最后完成的一次迭代。
+ *
+ * @param game 棋局编号
+ * @param deadline 截止时间
+ * @param done 回调，参数为棋局编号与搜索结果，走法 -1 表示弃权
+ * @param depth 最大搜索深度，0 表示只受截止时间限制
+ * @param evaluator 评估函数
+ * @return 棋局存在且未在搜索时返回 true
+ */
+bool othelloHost::requestMove(int game,
+        std::chrono::steady_clock::time_point deadline, moveCallback done,
+        int depth, evaluatorType evaluator) {
+    std::shared_ptr<hostedGame> state;
+    othelloBoard root;
+    int toMove = 1;
+    searchResult immediate;
+    bool answered = true;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->hosted.find(game);
+        if (it == this->hosted.end() || it->second->searching) {
+            return false;
+        }
+        state = it->second;
+        root.positions = state->board.positions;
+        root.discsOnBoard = state->board.discsOnBoard;
+        toMove = state->toMove;
+
+        root.findLegalMoves(toMove, &root.moves);
+        int bookMove = state->bookUsable
+            ? othelloDatabase::instance().probe(state->moveHistory) : -1;
+        if (root.moves.empty()) {
+            immediate.move = -1;
+        }
+        else if (root.moves.size() == 1) {
+            immediate.move = root.moves.begin()->first;
+        }
+        else if (root.moves.find(bookMove) != root.moves.end()) {
+            immediate.move = bookMove;
+        }
+        else {
+            answered = false;
+            state->searching = true;
+
+            // Age the table once per round of as many searches as there
+            // are games, so that the entries of searches still running in
+            // other games stay current
+            if (++this->searchesSinceAgeing >= (int) this->hosted.size()) {
+                this->sharedTable.newSearch();
+                this->searchesSinceAgeing = 0;
+            }
+        }
+    }
+
+    // Called outside the lock, so done may call back into the host
+    if (answered) {
+        immediate.pv.assign(immediate.move == -1 ? 0 : 1, immediate.move);
+        done(game, immediate);
+        return true;
+    }
+    root.moves.clear();
+
+    searchLimits limits;
+    limits.depth = depth;
+    std::chrono::duration<float> remaining =
+        deadline - std::chrono::steady_clock::now();
+    limits.time = std::max(remaining.count(), 1e-3f);
+
+    std::shared_ptr<othelloSearch> search = std::make_shared<othelloSearch>(
+            root, toMove, limits, evaluator, &this->sharedTable);
+    long long priority = deadline.time_since_epoch().count();
+    this->pool.submit([this, game, state, search, deadline, done](int) {
+        this->runSlice(game, state, search, deadline, done);
+    }, priority);
+    return true;
+}
+
+// Searches one slice and queues the next, or reports the result
+/**
+ * @brief 执行一次搜索分片
+ *
+ * 分片结束后，若搜索未完成且截止时间未到，则以相同优先级重新提交，
+ * 使其他截止时间更早的棋局可以插入；否则结束搜索并回调。
+ */
+void othelloHost::runSlice(int game, std::shared_ptr<hostedGame> state,
+        std::shared_ptr<othelloSearch> search,
+        std::chrono::steady_clock::time_point deadline, moveCallback done) {
+    search->step(this->sliceNodes);
+
+    if (!search->done() && std::chrono::steady_clock::now() < deadline
+            && !this->shuttingDown && !state->closed) {
+        this->pool.submit([this, game, state, search, deadline, done](int) {
+            this->runSlice(game, state, search, deadline, done);
+        }, deadline.time_since_epoch().count());
+        return;
+    }
+
+    search->stop();
+    this->finish(game, state, search->result(), done);
+}
+
+void othelloHost::finish(int game, std::shared_ptr<hostedGame> state,
+        const searchResult &result, moveCallback &done) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        state->searching = false;
+    }
+    done(game, result);
+}
+
+bool othelloHost::gameState(int game, othelloBoard &board, int &toMove,
+        bool &over) {
+    std::shared_ptr<hostedGame> state = this->find(game);
+    if (!state) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    board.positions = state->board.positions;
+    board.discsOnBoard = state->board.discsOnBoard;
+    board.moves.clear();
+    toMove = state->toMove;
+    over = state->over;
+    return true;
+}
+
+bool othelloHost::closeGame(int game) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->hosted.find(game);
+    if (it == this->hosted.end()) {
+        return false;
+    }
+
+    it->second->closed = true;
+    this->hosted.erase(it);
+    return true;
+}
+
+void othelloHost::wait() {
+    this->pool.wait();
+}
+
+int othelloHost::games() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->hosted.size();
+}
+
+othelloTable &othelloHost::table() {
+    return this->sharedTable;
+}
+
+std::shared_ptr<othelloHost::hostedGame> othelloHost::find(int game) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->hosted.find(game);
+    return (it == this->hosted.end()) ? nullptr : it->second;
+}
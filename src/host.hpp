@@ -0,0 +1,96 @@
+#ifndef HOST_HPP
+#define HOST_HPP
+
+#include <map>
+#include "search.hpp"
+#include "table.hpp"
+#include "threadpool.hpp"
+
+// Hosts many concurrent games on one fixed pool of search threads. Engine
+// moves are searched as resumable searches (see search.hpp) in slices of a
+// fixed number of nodes, and the pool always runs the slice with the
+// earliest deadline first. All games share the opening book and one
+// transposition table of fixed size, so memory does not grow with the
+// number of games: an idle game only keeps its position and move history.
+// All methods are safe to call from any thread.
+class othelloHost {
+    public:
+        // Called once per requestMove with the game and the chosen move
+        // (-1 to pass), from a pool thread or from requestMove itself
+        typedef std::function<void(int, const searchResult &)> moveCallback;
+
+        othelloHost(int threads, size_t tableBytes, long long sliceNodes = 2000);
+        // Running searches are finished early and their callbacks called
+        ~othelloHost();
+
+        othelloHost(const othelloHost &) = delete;
+        othelloHost &operator=(const othelloHost &) = delete;
+
+        // Starts a game from the start position, or from a set-up position
+        // (where the opening book is not used); returns its id
+        int createGame();
+        int createGame(const othelloBoard &board, int toMove);
+
+        // Plays square (-1 to pass) for the side to move. Returns false if
+        // the game does not exist, the move is illegal or a search for the
+        // game is running.
+        bool submitMove(int game, int square);
+
+        // Chooses a move for the side to move, answering from the opening
+        // book when possible and otherwise searching until deadline (or to
+        // depth, if given). The move is not played; done receives it.
+        // Returns false if the game does not exist or is already searching.
+        bool requestMove(int game, std::chrono::steady_clock::time_point deadline,
+                moveCallback done, int depth = 0,
+                evaluatorType evaluator = evaluatorType::standard);
+
+        // Copies the position of a game; returns false if it does not exist
+        bool gameState(int game, othelloBoard &board, int &toMove,
+                bool &over);
+
+        // Forgets a game. A running search for it stops after the current
+        // slice and still calls its callback.
+        bool closeGame(int game);
+
+        // Blocks until no search is running
+        void wait();
+
+        int games();
+        othelloTable &table();
+
+    private:
+        struct hostedGame {
+            othelloBoard board;
+            int toMove = 1;
+            // Move history for the opening book; unusable after a pass or
+            // for a set-up position
+            std::string moveHistory;
+            bool bookUsable = true;
+            bool over = false;
+            bool searching = false;
+            std::atomic<bool> closed{false};
+        };
+
+        std::mutex mutex;
+        std::map<int, std::shared_ptr<hostedGame>> hosted;
+        int nextId = 0;
+        // Searches started since the table was last aged
+        int searchesSinceAgeing = 0;
+        std::atomic<bool> shuttingDown{false};
+        long long sliceNodes;
+        othelloTable sharedTable;
+        // Last member, so that its threads are joined before the rest is
+        // destroyed
+        othelloThreadPool pool;
+
+        int addGame(std::shared_ptr<hostedGame> state);
+        std::shared_ptr<hostedGame> find(int game);
+        void runSlice(int game, std::shared_ptr<hostedGame> state,
+                std::shared_ptr<othelloSearch> search,
+                std::chrono::steady_clock::time_point deadline,
+                moveCallback done);
+        void finish(int game, std::shared_ptr<hostedGame> state,
+                const searchResult &result, moveCallback &done);
+};
+
+#endif // HOST_HPP
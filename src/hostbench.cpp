@@ -0,0 +1,201 @@
+// Benchmark and check of the multi-game host.
+//
+// Usage: hostbench.exe [--games N] [--threads N] [--time S] [--slice N]
+//                      [--hash MB]
+//
+// Plays --games engine-vs-engine games at once on one othelloHost (see
+// host.hpp) with --threads search threads and slices of --slice nodes.
+// Every move is requested with its own deadline, --time seconds away for
+// the first game in three, twice that for the second and three times for
+// the third, so that the earliest-deadline-first order of the slices
+// matters. One more game, set up from the start position so that the book
+// does not answer it, is closed while its first search runs; its callback
+// must still be called. Reports the moves, nodes and how late the answers
+// came relative to their deadlines, and fails if a chosen move is illegal,
+// a callback is missing or a game does not finish.
+
+#include <condition_variable>
+#include <deque>
+#include "host.hpp"
+
+typedef std::chrono::steady_clock benchClock;
+
+// A move chosen by the host, waiting for the main thread to play it
+struct hostReply {
+    int game;
+    searchResult result;
+    // Time of the callback minus the deadline, in seconds
+    double lateness;
+};
+
+int main(int argc, char **argv) {
+    int games = 16, threads = std::thread::hardware_concurrency();
+    float time = 0.05;
+    long long sliceNodes = 2000;
+    size_t hashBytes = 16 << 20;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--games") {
+                games = std::stoi(value);
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value);
+            }
+            else if (arg == "--time") {
+                time = std::stof(value);
+            }
+            else if (arg == "--slice") {
+                sliceNodes = std::stoll(value);
+            }
+            else if (arg == "--hash") {
+                hashBytes = std::stoul(value) << 20;
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+    if (games < 1 || threads < 1 || time <= 0 || sliceNodes < 1) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    std::mutex mutex;
+    std::condition_variable replied;
+    std::deque<hostReply> replies;
+    // Deadline of the request running for each game, by game id
+    std::vector<benchClock::time_point> deadlines(games + 1);
+
+    othelloHost host(threads, hashBytes, sliceNodes);
+    othelloHost::moveCallback done = [&](int game,
+            const searchResult &result) {
+        std::chrono::duration<double> late = benchClock::now()
+            - deadlines[game];
+        std::lock_guard<std::mutex> lock(mutex);
+        replies.push_back(hostReply{game, result, late.count()});
+        replied.notify_one();
+    };
+    auto request = [&](int game) {
+        deadlines[game] = benchClock::now()
+            + std::chrono::duration_cast<benchClock::duration>(
+                    std::chrono::duration<float>(time * (1 + game % 3)));
+        return host.requestMove(game, deadlines[game], done);
+    };
+
+    std::cout << "Hosting " << games << " games on " << threads
+        << " threads, slices of " << sliceNodes << " nodes" << std::endl;
+    auto start = benchClock::now();
+
+    for (int i = 0; i < games; i++) {
+        host.createGame();
+    }
+    othelloBoard setUp;
+    setUp.startPosition();
+    int closedGame = host.createGame(setUp, 1);
+
+    bool failed = false;
+    for (int i = 0; i < games; i++) {
+        if (!request(i)) {
+            std::cout << "Game " << i << ": move request refused"
+                << std::endl;
+            failed = true;
+        }
+    }
+    if (!request(closedGame) || !host.closeGame(closedGame)) {
+        std::cout << "Could not close a game while it searches" << std::endl;
+        failed = true;
+    }
+
+    // Play every chosen move and ask for the next one until all games end
+    int running = games, closedCallbacks = 0;
+    long long moves = 0, searched = 0, nodes = 0;
+    double totalLateness = 0, maxLateness = 0;
+    while (running > 0 && !failed) {
+        hostReply reply;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!replied.wait_for(lock, std::chrono::seconds(60),
+                        [&replies] { return !replies.empty(); })) {
+                std::cout << "No answer from the host for 60s" << std::endl;
+                failed = true;
+                break;
+            }
+            reply = replies.front();
+            replies.pop_front();
+        }
+
+        if (reply.game == closedGame) {
+            closedCallbacks++;
+            continue;
+        }
+        moves++;
+        if (reply.result.nodes > 0) {
+            searched++;
+            nodes += reply.result.nodes;
+            totalLateness += reply.lateness;
+            maxLateness = std::max(maxLateness, reply.lateness);
+        }
+
+        othelloBoard board;
+        int toMove;
+        bool over;
+        if (!host.submitMove(reply.game, reply.result.move)) {
+            std::cout << "Game " << reply.game << ": illegal move "
+                << reply.result.move << std::endl;
+            failed = true;
+        }
+        else if (!host.gameState(reply.game, board, toMove, over)) {
+            std::cout << "Game " << reply.game << ": lost" << std::endl;
+            failed = true;
+        }
+        else if (over) {
+            running--;
+        }
+        else if (!request(reply.game)) {
+            std::cout << "Game " << reply.game << ": move request refused"
+                << std::endl;
+            failed = true;
+        }
+    }
+
+    host.wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const hostReply &reply : replies) {
+            closedCallbacks += (reply.game == closedGame) ? 1 : 0;
+        }
+    }
+    if (closedCallbacks != 1) {
+        std::cout << "The closed game got " << closedCallbacks
+            << " callbacks instead of 1" << std::endl;
+        failed = true;
+    }
+    if (host.submitMove(closedGame, -1) || host.games() != games) {
+        std::cout << "The closed game is still hosted" << std::endl;
+        failed = true;
+    }
+
+    std::chrono::duration<double> elapsed = benchClock::now() - start;
+    std::cout << games - running << " games finished, " << moves
+        << " moves (" << searched << " searched), " << nodes << " nodes in "
+        << elapsed.count() << "s, "
+        << (long long) (nodes / std::max(elapsed.count(), 1e-6))
+        << " nodes/s" << std::endl;
+    std::cout << "Searched answers relative to their deadlines: mean "
+        << 1000 * totalLateness / std::max(searched, 1LL) << "ms, latest "
+        << 1000 * maxLateness << "ms" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,473 @@
+#include <array>
+#include <cmath>
+#include <thread>
+#include <type_traits>
+#include "mcts.hpp"
+
+namespace {
+    // Bitboards for the playouts and the tree: bit i for square i
+    using bits = std::conditional<boardSquares <= 64, uint64_t,
+          unsigned __int128>::type;
+
+    constexpr bits one = 1;
+
+    constexpr bits columnBits(int col) {
+        bits b = 0;
+        for (int row = 0; row < boardSide; row++) {
+            b |= one << geometry::square(row, col);
+        }
+        return b;
+    }
+
+    constexpr bits boardBits() {
+        bits b = 0;
+        for (int i = 0; i < boardSquares; i++) {
+            b |= one << i;
+        }
+        return b;
+    }
+
+    constexpr bits cornerBits() {
+        bits b = 0;
+        for (int corner : geometry::corners) {
+            b |= one << corner;
+        }
+        return b;
+    }
+
+    constexpr bits allSquares = boardBits();
+    constexpr bits corners = cornerBits();
+    constexpr bits notLeft = allSquares & ~columnBits(0);
+    constexpr bits notRight = allSquares & ~columnBits(boardSide - 1);
+
+    // Squares a disc can land on when moved one step in each of
+    // geometry::directions, so that no step wraps around to another row
+    constexpr bits stepMasks[8] = {notRight, notLeft, allSquares, allSquares,
+        notRight, notLeft, notLeft, notRight};
+
+    template <int d>
+    inline bits step(bits b) {
+        constexpr int offset = geometry::directions[d];
+        if constexpr (offset > 0) {
+            return (b << offset) & stepMasks[d];
+        }
+        else {
+            return (b >> -offset) & stepMasks[d];
+        }
+    }
+
+    // Empty squares where player flanks a line of opponent discs, one
+    // direction at a time
+    template <int d = 0>
+    inline bits legalMoves(bits player, bits opponent, bits empty) {
+        if constexpr (d == 8) {
+            return 0;
+        }
+        else {
+            bits line = step<d>(player) & opponent;
+            for (int i = 0; i < boardSide - 3; i++) {
+                line |= step<d>(line) & opponent;
+            }
+            return (step<d>(line) & empty)
+                | legalMoves<d + 1>(player, opponent, empty);
+        }
+    }
+
+    // Opponent discs flipped by player's disc on square (a single bit)
+    template <int d = 0>
+    inline bits flips(bits square, bits player, bits opponent) {
+        if constexpr (d == 8) {
+            return 0;
+        }
+        else {
+            bits line = 0;
+            bits next = step<d>(square);
+            while (next & opponent) {
+                line |= next;
+                next = step<d>(next);
+            }
+            return ((next & player) ? line : 0)
+                | flips<d + 1>(square, player, opponent);
+        }
+    }
+
+    inline int bitCount(uint64_t b) {
+        return __builtin_popcountll(b);
+    }
+
+    inline int bitCount(unsigned __int128 b) {
+        return __builtin_popcountll((uint64_t) b)
+            + __builtin_popcountll((uint64_t) (b >> 64));
+    }
+
+    inline int lowestSquare(uint64_t b) {
+        return __builtin_ctzll(b);
+    }
+
+    inline int lowestSquare(unsigned __int128 b) {
+        uint64_t low = (uint64_t) b;
+        return low ? __builtin_ctzll(low)
+            : 64 + __builtin_ctzll((uint64_t) (b >> 64));
+    }
+
+    // One of the moves, uniformly at random, as a single bit
+    inline bits randomMove(bits moves, std::minstd_rand &random) {
+        for (int k = random() % bitCount(moves); k > 0; k--) {
+            moves &= moves - 1;
+        }
+        return moves & (0 - moves);
+    }
+
+    // Plays random moves from the position to the end of the game and
+    // returns black's discs minus white's
+    int playout(bits black, bits white, int toMove, bool biased,
+            std::minstd_rand &random) {
+        bits player = (toMove == 1) ? black : white;
+        bits opponent = (toMove == 1) ? white : black;
+        int side = toMove;
+        int passes = 0;
+
+        while (passes < 2) {
+            bits moves = legalMoves(player, opponent,
+                    allSquares & ~(player | opponent));
+            if (moves == 0) {
+                passes++;
+            }
+            else {
+                passes = 0;
+                if (biased && (moves & corners)) {
+                    moves &= corners;
+                }
+                bits square = randomMove(moves, random);
+                bits flipped = flips(square, player, opponent);
+                player |= square | flipped;
+                opponent &= ~flipped;
+            }
+            std::swap(player, opponent);
+            side = -side;
+        }
+
+        return side*(bitCount(player) - bitCount(opponent));
+    }
+}
+
+struct othelloMCTS::node {
+    bits black = 0;
+    bits white = 0;
+    // Side to move; the move that led here (-1 for a pass) was the other
+    // side's
+    int toMove = 1;
+    int move = -1;
+    // Visits are counted on the way down and results added on the way up,
+    // in half points (2 for a win, 1 for a draw) for the side that moved
+    std::atomic<int> visits{0};
+    std::atomic<long long> halfPoints{0};
+    // 0 leaf, 1 being expanded, 2 expanded; children and childCount are
+    // only read once the state is 2. An expanded node without children is
+    // a finished game.
+    std::atomic<int> state{0};
+    int childCount = 0;
+    std::unique_ptr<node[]> children;
+
+    size_t size() const {
+        size_t count = 1;
+        for (int i = 0; i < this->childCount; i++) {
+            count += this->children[i].size();
+        }
+        return count;
+    }
+};
+
+othelloMCTS::othelloMCTS() {
+}
+
+othelloMCTS::~othelloMCTS() {
+}
+
+void othelloMCTS::seed(unsigned value) {
+    this->random.seed(value);
+}
+
+size_t othelloMCTS::size() const {
+    return this->nodeCount.load();
+}
+
+long long othelloMCTS::rootPlayouts() const {
+    return this->root ? this->root->visits.load() : 0;
+}
+
+// Runs playouts in parallel until a limit is reached
+/**
+ * @brief 蒙特卡洛树搜索
+ *
+ * 先把树根移到当前局面（若它在上次搜索的树中，则保留其子树），再由 threads
+ * 个线程同时在同一棵树上做选择、扩展、随机对局与回传，直到达到时间或对局数
+ * 限制，或 stop（或 outerStop）被置位。若没有任何随机对局完成，返回第一个
+ * 合法走法。
+ *
+ * @param board 当前局面
+ * @param color 轮到走棋的一方
+ * @param limits 时间限制，以及 limits.nodes 作为随机对局数限制
+ * @return 访问次数最多的走法、其期望结果（-1000 到 1000）、主要变例与对局数
+ */
+searchResult othelloMCTS::search(const othelloBoard &board, int color,
+        const searchLimits &limits) {
+    std::chrono::time_point<std::chrono::steady_clock> startTime
+        = std::chrono::steady_clock::now();
+    searchResult result;
+    this->stop = false;
+
+    this->reroot(board, color);
+    this->expand(*this->root);
+
+    long long playoutLimit = limits.nodes;
+    if (limits.time <= 0 && playoutLimit <= 0) {
+        playoutLimit = defaultPlayouts;
+    }
+    std::chrono::time_point<std::chrono::steady_clock> deadline
+        = (limits.time > 0)
+        ? startTime + std::chrono::duration_cast<
+            std::chrono::steady_clock::duration>(
+                    std::chrono::duration<float>(limits.time))
+        : std::chrono::time_point<std::chrono::steady_clock>::max();
+
+    std::atomic<long long> playouts(0);
+    std::vector<std::thread> workers;
+    for (int i = 1; i < this->threads; i++) {
+        workers.emplace_back(&othelloMCTS::work, this, this->random(),
+                playoutLimit, deadline, std::ref(playouts));
+    }
+    this->work(this->random(), playoutLimit, deadline, playouts);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    // The most visited line; its first move is the one to play
+    const node *n = this->root.get();
+    while (n->state.load(std::memory_order_acquire) == 2
+            && n->childCount > 0) {
+        const node *best = &n->children[0];
+        for (int i = 1; i < n->childCount; i++) {
+            if (n->children[i].visits.load() > best->visits.load()) {
+                best = &n->children[i];
+            }
+        }
+        if (best->visits.load() == 0) {
+            break;
+        }
+        if (n == this->root.get()) {
+            result.move = best->move;
+            result.score = (int) (1000*((double) best->halfPoints.load()
+                        / best->visits.load() - 1));
+        }
+        result.pv.push_back(best->move);
+        n = best;
+    }
+
+    // Stopped before any playout finished: the first legal move, as
+    // alpha-beta falls back to
+    if (result.pv.empty() && this->root->childCount > 0) {
+        result.move = this->root->children[0].move;
+        result.pv.push_back(result.move);
+    }
+
+    result.depth = result.pv.size();
+    result.nodes = playouts.load();
+    result.time = std::chrono::duration<float>(
+            std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+// Selection, expansion, playout and backup, repeated
+/**
+ * @brief 单个线程的搜索循环
+ *
+ * 自根向下按 UCB1 选择子节点，路径上每个节点的访问数在下行时即加一（虚拟
+ * 损失），结果在随机对局结束后才加入，因此其他线程会暂时避开这条路径。
+ * 第二次到达的叶子被扩展；树已满或另一线程正在扩展时，从该叶子直接随机对局。
+ *
+ * @param seed 本线程随机数生成器的种子
+ * @param playoutLimit 所有线程合计的随机对局数上限，0 表示不限
+ * @param deadline 截止时间
+ * @param playouts 所有线程合计完成的随机对局数
+ */
+void othelloMCTS::work(unsigned seed, long long playoutLimit,
+        std::chrono::time_point<std::chrono::steady_clock> deadline,
+        std::atomic<long long> &playouts) {
+    std::minstd_rand random(seed);
+    // A line of moves and passes, never two passes in a row
+    std::array<node *, 2*boardSquares> path;
+
+    for (long long i = 0; ; i++) {
+        if (this->stop.load(std::memory_order_relaxed)
+                || (this->outerStop != nullptr
+                    && this->outerStop->load(std::memory_order_relaxed))
+                || (playoutLimit > 0
+                    && playouts.load(std::memory_order_relaxed)
+                        >= playoutLimit)
+                || ((i & 63) == 0
+                    && std::chrono::steady_clock::now() >= deadline)) {
+            break;
+        }
+
+        node *n = this->root.get();
+        n->visits.fetch_add(1, std::memory_order_relaxed);
+        int length = 0;
+        path[length++] = n;
+        bool finished = false;
+
+        while (true) {
+            if (n->state.load(std::memory_order_acquire) != 2
+                    && (n->visits.load(std::memory_order_relaxed) < 2
+                        || !this->expand(*n))) {
+                break;
+            }
+            if (n->childCount == 0) {
+                finished = true;
+                break;
+            }
+
+            double logVisits = std::log(
+                    (double) n->visits.load(std::memory_order_relaxed));
+            node *best = nullptr;
+            double bestValue = -1;
+            for (int c = 0; c < n->childCount; c++) {
+                node &child = n->children[c];
+                int visits = child.visits.load(std::memory_order_relaxed);
+                if (visits == 0) {
+                    best = &child;
+                    break;
+                }
+                double value = child.halfPoints.load(
+                        std::memory_order_relaxed) / (2.0*visits)
+                    + this->exploration*std::sqrt(logVisits / visits);
+                if (value > bestValue) {
+                    bestValue = value;
+                    best = &child;
+                }
+            }
+
+            best->visits.fetch_add(1, std::memory_order_relaxed);
+            n = best;
+            path[length++] = n;
+        }
+
+        int result = finished ? bitCount(n->black) - bitCount(n->white)
+            : playout(n->black, n->white, n->toMove, this->biased, random);
+        for (int j = 0; j < length; j++) {
+            int mover = -path[j]->toMove;
+            path[j]->halfPoints.fetch_add(
+                    (result*mover > 0) ? 2 : (result == 0) ? 1 : 0,
+                    std::memory_order_relaxed);
+        }
+        playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Creates a child for every legal move, or a single pass
+bool othelloMCTS::expand(node &n) {
+    int expected = 0;
+    if ((&n != this->root.get()
+                && this->nodeCount.load(std::memory_order_relaxed)
+                    >= this->maxNodes)
+            || !n.state.compare_exchange_strong(expected, 1)) {
+        return false;
+    }
+
+    bits player = (n.toMove == 1) ? n.black : n.white;
+    bits opponent = (n.toMove == 1) ? n.white : n.black;
+    bits empty = allSquares & ~(n.black | n.white);
+    bits moves = legalMoves(player, opponent, empty);
+
+    int count = bitCount(moves);
+    if (count == 0 && legalMoves(opponent, player, empty) != 0) {
+        count = 1;
+    }
+    if (count > 0) {
+        std::unique_ptr<node[]> children(new node[count]);
+        for (int i = 0; i < count; i++) {
+            node &child = children[i];
+            child.toMove = -n.toMove;
+            bits mine = player, theirs = opponent;
+            if (moves != 0) {
+                bits square = moves & (0 - moves);
+                moves &= moves - 1;
+                bits flipped = flips(square, player, opponent);
+                mine |= square | flipped;
+                theirs &= ~flipped;
+                child.move = lowestSquare(square);
+            }
+            child.black = (n.toMove == 1) ? mine : theirs;
+            child.white = (n.toMove == 1) ? theirs : mine;
+        }
+        n.children = std::move(children);
+        n.childCount = count;
+        this->nodeCount.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    n.state.store(2, std::memory_order_release);
+    return true;
+}
+
+// Keeps the subtree of the position if the last search reached it
+/**
+ * @brief 移动树根以复用上次搜索的树
+ *
+ * 在旧树根、其子节点与孙节点中查找与当前局面（棋子与轮到的一方）相同的节点，
+ * 找到时以它为新树根并保留其子树，其余部分释放；否则从空树开始。
+ *
+ * @param board 当前局面
+ * @param color 轮到走棋的一方
+ */
+void othelloMCTS::reroot(const othelloBoard &board, int color) {
+    bits black = 0, white = 0;
+    for (int i = 0; i < boardSquares; i++) {
+        if (board.positions[i] == 1) {
+            black |= one << i;
+        }
+        else if (board.positions[i] == -1) {
+            white |= one << i;
+        }
+    }
+
+    auto same = [&](const node &n) {
+        return n.black == black && n.white == white && n.toMove == color;
+    };
+    auto expanded = [](const node &n) {
+        return n.state.load(std::memory_order_acquire) == 2;
+    };
+
+    node *match = nullptr;
+    if (this->root && same(*this->root)) {
+        return;
+    }
+    if (this->root && expanded(*this->root)) {
+        for (int i = 0; i < this->root->childCount && !match; i++) {
+            node &child = this->root->children[i];
+            if (same(child)) {
+                match = &child;
+            }
+            for (int j = 0; expanded(child) && j < child.childCount
+                    && !match; j++) {
+                if (same(child.children[j])) {
+                    match = &child.children[j];
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<node> next(new node());
+    next->black = black;
+    next->white = white;
+    next->toMove = color;
+    if (match != nullptr) {
+        next->move = match->move;
+        next->visits.store(match->visits.load());
+        next->halfPoints.store(match->halfPoints.load());
+        next->state.store(match->state.load());
+        next->childCount = match->childCount;
+        next->children = std::move(match->children);
+    }
+    this->root = std::move(next);
+    this->nodeCount.store(this->root->size());
+}
@@ -0,0 +1,87 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include "player.hpp"
+
+// Monte-Carlo tree search (UCT), the alternative to alpha-beta for fast
+// time controls. Every iteration walks down the tree by the UCB1 formula,
+// expands the node it stops at and plays a random game from there on
+// bitboards, without touching othelloBoard or the heap; the result (win,
+// draw or loss) is backed up along the path.
+//
+// The tree is searched by several threads at once. A thread counts its
+// visit to every node on its path as it walks down and adds the result
+// only when the playout is over, so until then the visit is a virtual loss
+// that steers the other threads to other moves. The tree is kept after a
+// search, and the next search starts from the node of its position if it
+// is within two plies (our move and the reply) of the last root.
+class othelloMCTS {
+    public:
+        othelloMCTS();
+        ~othelloMCTS();
+
+        othelloMCTS(const othelloMCTS &) = delete;
+        othelloMCTS &operator=(const othelloMCTS &) = delete;
+
+        // Searches board for color to move within limits: time, and
+        // limits.nodes as the number of playouts; defaultPlayouts if
+        // neither is given. result.move is the most visited root move,
+        // result.score its expected result for color from -1000 (a
+        // certain loss) to 1000 (a certain win), result.pv the most visited
+        // line and result.nodes the playouts run by this search. If no
+        // playout finishes in time, result.move is the first legal move.
+        searchResult search(const othelloBoard &board, int color,
+                const searchLimits &limits);
+
+        // Threads searching the tree
+        int threads = 1;
+        // Exploration constant of UCB1
+        double exploration = 1.0;
+        // Playouts take a corner whenever one is available, and otherwise
+        // a random move
+        bool biased = false;
+        // The tree stops growing at this many nodes; playouts go on from
+        // its leaves
+        size_t maxNodes = 4 << 20;
+
+        static const long long defaultPlayouts = 10000;
+
+        // Set from any thread to end the running search; cleared when a
+        // search starts
+        std::atomic<bool> stop{false};
+        // Another flag that ends the search when set, such as the stop flag
+        // of the player using the tree, or nullptr
+        const std::atomic<bool> *outerStop = nullptr;
+
+        // Seeds the generators of the playouts
+        void seed(unsigned value);
+
+        // Nodes in the tree, and playouts through its root, including
+        // those of earlier searches that were reused
+        size_t size() const;
+        long long rootPlayouts() const;
+
+    private:
+        struct node;
+
+        std::unique_ptr<node> root;
+        std::atomic<size_t> nodeCount{0};
+        std::minstd_rand random;
+
+        // Runs playouts on one thread until the search ends
+        void work(unsigned seed, long long playoutLimit,
+                std::chrono::time_point<std::chrono::steady_clock> deadline,
+                std::atomic<long long> &playouts);
+        // Creates the children of a node; returns false if another thread
+        // is expanding it or the tree is full
+        bool expand(node &n);
+        // Moves the root to the node of the given position, if it is in the
+        // tree, and drops everything else
+        void reroot(const othelloBoard &board, int color);
+};
+
+#endif // MCTS_HPP
@@ -1,3 +1,5 @@
+#include "analysis.hpp"
+#include "engine.hpp"
 #include "game.hpp"
 
 int promptNewGame();
@@ -13,7 +15,19 @@ float promptAITimeLimit();
  *
  * @return 返回值始终为0，表示程序正常结束
  */
-int main() {
+int main(int argc, char **argv) {
+    // 无交互的批量分析模式
+    // Headless batch analysis
+    if (argc > 1 && std::string(argv[1]) == "--analyze") {
+        return runAnalysis(argc, argv);
+    }
+
+    // 供图形界面和比赛管理程序使用的文本协议模式
+    // Text protocol engine mode
+    if (argc > 1 && std::string(argv[1]) == "--engine") {
+        return runEngine(argc, argv);
+    }
+
     othelloBoard board;
     // 初始化棋盘
     othelloGame game;
@@ -0,0 +1,183 @@
+// Move generator correctness and speed check.
+//
+// Usage: perft.exe [--depth N] [--divide] [FILE...]
+//
+// Counts the leaf positions of the game tree to depth N (default 8) from the
+// start position, or from every position in the given files (save files or
+// the one-line format of --analyze). A pass counts as a ply, and a finished
+// game is a leaf wherever it occurs. Counts from the start position and the
+// boards under test/ are checked against known values; the exit status is
+// non-zero if any of them differ.
+
+#include <chrono>
+#include "analysis.hpp"
+
+// Known leaf counts from the start position, by depth
+const std::vector<long long> startCounts = {1, 4, 12, 56, 244, 1396, 8200,
+    55092, 390216, 3005288, 24571284};
+
+// Known leaf counts for the example boards under test/, by depth
+const std::vector<std::pair<std::string, std::vector<long long>>> testCounts = {
+    {"board1.txt", {1, 3, 10, 18, 29, 29, 29, 29}},
+    {"board2.txt", {1, 7, 33, 237, 1852, 15898, 143266, 1365045}},
+    {"board3.txt", {1, 7, 41, 327, 2267, 22431, 183445, 2030936}}
+};
+
+/**
+ * @brief 统计给定深度下的叶子局面数
+ *
+ * @param board 当前局面
+ * @param color 轮到的一方
+ * @param depth 剩余深度
+ * @param passed 上一步是否为弃权
+ * @return 叶子局面数
+ */
+long long perft(const othelloBoard &board, int color, int depth, bool passed) {
+    if (depth == 0) {
+        return 1;
+    }
+
+    othelloBoard child = board;
+    child.findLegalMoves(color, &child.moves);
+    if (child.moves.empty()) {
+        // Both sides passed: the game is over
+        if (passed) {
+            return 1;
+        }
+        return perft(board, -color, depth - 1, true);
+    }
+    if (depth == 1) {
+        return child.moves.size();
+    }
+
+    long long leaves = 0;
+    for (auto move : child.moves) {
+        othelloBoard next = board;
+        next.updateBoard(color, move);
+        next.discsOnBoard++;
+        leaves += perft(next, -color, depth - 1, false);
+    }
+    return leaves;
+}
+
+// Returns the known count for a position, or -1 if there is none
+long long knownCount(const std::string &id, int depth) {
+    // The counts are those of the standard board
+    if (boardSide != 8) {
+        return -1;
+    }
+
+    const std::vector<long long> *counts = nullptr;
+    if (id == "startpos") {
+        counts = &startCounts;
+    }
+    for (const auto &test : testCounts) {
+        size_t length = test.first.length();
+        if (id.length() >= length
+                && id.compare(id.length() - length, length, test.first) == 0) {
+            counts = &test.second;
+        }
+    }
+
+    if (counts == nullptr || depth >= (int) counts->size()) {
+        return -1;
+    }
+    return (*counts)[depth];
+}
+
+/**
+ * @brief 对一个局面逐层运行 perft 并与已知结果比对
+ *
+ * @param task 局面
+ * @param maxDepth 最大深度
+ * @param divide 是否在最大深度下按根节点走法分别输出
+ * @return 所有已知结果均一致时返回 true
+ */
+bool runPerft(const analysisTask &task, int maxDepth, bool divide) {
+    bool ok = true;
+    std::cout << task.id << std::endl;
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        auto start = std::chrono::steady_clock::now();
+        long long leaves = perft(task.board, task.toMove, depth, false);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        long long expected = knownCount(task.id, depth);
+        std::cout << "  depth " << depth << "  leaves " << leaves
+            << "  time " << elapsed.count() << "s  nps "
+            << (long long) (leaves / std::max(elapsed.count(), 1e-6));
+        if (expected >= 0 && expected != leaves) {
+            std::cout << "  FAIL (expected " << expected << ")";
+            ok = false;
+        }
+        else if (expected >= 0) {
+            std::cout << "  ok";
+        }
+        std::cout << std::endl;
+    }
+
+    if (divide && maxDepth > 0) {
+        othelloBoard board = task.board;
+        board.findLegalMoves(task.toMove, &board.moves);
+        for (auto move : board.moves) {
+            othelloBoard next = task.board;
+            next.updateBoard(task.toMove, move);
+            next.discsOnBoard++;
+            std::cout << "  " << index2string(move.first) << " "
+                << perft(next, -task.toMove, maxDepth - 1, false) << std::endl;
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int maxDepth = 8;
+    bool divide = false;
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--divide") {
+                divide = true;
+            }
+            else if (arg == "--depth" && i + 1 < argc) {
+                maxDepth = std::stoi(argv[++i]);
+            }
+            else if (arg.compare(0, 2, "--") == 0) {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+            else {
+                inputs.push_back(arg);
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    std::vector<analysisTask> tasks;
+    std::string error;
+    if (inputs.empty()) {
+        analysisTask task;
+        task.id = "startpos";
+        task.board.startPosition();
+        tasks.push_back(task);
+    }
+    for (const std::string &input : inputs) {
+        if (!readPositions(input, searchLimits(), tasks, error)) {
+            std::cout << error << std::endl;
+            return 1;
+        }
+    }
+
+    bool ok = true;
+    for (const analysisTask &task : tasks) {
+        ok = runPerft(task, maxDepth, divide) && ok;
+    }
+    return ok ? 0 : 1;
+}
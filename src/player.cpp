@@ -1,4 +1,5 @@
 #include "heuristic.hpp"
+#include "mcts.hpp"
 #include "player.hpp"
 
 // Driver for player's move, regardless of player
@@ -140,105 +141,14 @@ std::pair<int, std::list<int>> othelloPlayer::humanMove(
 /**
  * @brief 将坐标字符串转换为棋盘上的索引
  *
- * 将一个表示棋盘坐标的字符串转换为棋盘上的索引。棋盘大小为8x8，坐标以字符串形式给出，如"A1"、"B2"等。
+ * 将一个表示棋盘坐标的字符串转换为棋盘上的索引。坐标以字符串形式给出，如"A1"、"B2"等。
  *
- * @param coord 坐标字符串，格式为'列号行号'，列号为大写或小写字母（A-H），行号为数字（1-8）
+ * @param coord 坐标字符串，格式为'列号行号'，列号为大写或小写字母（8x8 棋盘上为A-H），
+ *              行号为数字（8x8 棋盘上为1-8）
  * @return 索引值，如果坐标无效，则返回-1
  */
 int othelloPlayer::coord2index(std::string coord) {
-    // 检查坐标字符串长度是否为2
-    if (coord.length() != 2) {
-        return -1;
-    }
-
-    int index = 0;
-    // 根据坐标的第一个字符确定行索引
-    switch(coord.at(0)) {
-        case 'A':
-        case 'a':
-            // A或a代表第一行
-            index = 0;
-            break;
-        case 'B':
-        case 'b':
-            // B或b代表第二行
-            index = 1;
-            break;
-        case 'C':
-        case 'c':
-            // C或c代表第三行
-            index = 2;
-            break;
-        case 'D':
-        case 'd':
-            // D或d代表第四行
-            index = 3;
-            break;
-        case 'E':
-        case 'e':
-            // E或e代表第五行
-            index = 4;
-            break;
-        case 'F':
-        case 'f':
-            // F或f代表第六行
-            index = 5;
-            break;
-        case 'G':
-        case 'g':
-            // G或g代表第七行
-            index = 6;
-            break;
-        case 'H':
-        case 'h':
-            // H或h代表第八行
-            index = 7;
-            break;
-        default:
-            // 如果第一个字符不在A-H之间，则返回-1
-            return -1;
-    }
-
-    // 根据坐标的第二个字符确定列索引
-    switch(coord.at(1)) {
-        case '1':
-            // 1代表第一列
-            index += 0;
-            break;
-        case '2':
-            // 2代表第二列
-            index += 8;
-            break;
-        case '3':
-            // 3代表第三列
-            index += 16;
-            break;
-        case '4':
-            // 4代表第四列
-            index += 24;
-            break;
-        case '5':
-            // 5代表第五列
-            index += 32;
-            break;
-        case '6':
-            // 6代表第六列
-            index += 40;
-            break;
-        case '7':
-            // 7代表第七列
-            index += 48;
-            break;
-        case '8':
-            // 8代表第八列
-            index += 56;
-            break;
-        default:
-            // 如果第二个字符不在1-8之间，则返回-1
-            return -1;
-    }
-
-    return index;
+    return squareIndex(coord);
 }
 
 // Driver for the AI algorithm
@@ -261,78 +171,103 @@ std::pair<int, std::list<int>> othelloPlayer::computerMove(othelloBoard &board,
         = this->startTimer();
 
     // 初始化移动对象
-    std::pair<int, std::list<int>> move;
     std::pair<int, std::list<int>> bestMove;
+    this->lastSearch = searchResult();
 
     // 查询开局数据库
-    std::unordered_map<std::string, int>::iterator query
-        = this->database.openingBook.find(moveHistory);
+    int bookMove = this->useBook
+        ? othelloDatabase::instance().probe(moveHistory) : -1;
 
     // 如果没有合法移动
     if (legalMoves.empty()) {
-        std::cout << "No legal moves!" << std::endl;
-        std::cout << "\tComputer passes.\n" << std::endl;
+        if (this->verbose) {
+            std::cout << "No legal moves!" << std::endl;
+            std::cout << "\tComputer passes.\n" << std::endl;
+        }
         pass = true;
         return bestMove;
     }
     // 如果只有一个合法移动
     else if (legalMoves.size() == 1) {
-        std::cout << "Only one legal move!" << std::endl;
-        std::cout << "\tComputer takes only legal move." << std::endl;
+        if (this->verbose) {
+            std::cout << "Only one legal move!" << std::endl;
+            std::cout << "\tComputer takes only legal move." << std::endl;
+        }
         bestMove = *legalMoves.begin();
     }
     // 如果开局已知
-    else if (query != this->database.openingBook.end()) {
-        std::cout << "Known opening!" << std::endl;
-        std::cout << "\tComputer takes next move from opening book."
-            << std::endl;
-        bestMove = *legalMoves.find(query->second);
+    else if (bookMove != -1 && legalMoves.find(bookMove) != legalMoves.end()) {
+        if (this->verbose) {
+            std::cout << "Known opening!" << std::endl;
+            std::cout << "\tComputer takes next move from opening book."
+                << std::endl;
+        }
+        bestMove = *legalMoves.find(bookMove);
+    }
+    // 蒙特卡洛树搜索
+    else if (this->algorithm == searchAlgorithm::mcts) {
+        if (!this->mcts) {
+            this->mcts.reset(new othelloMCTS());
+            this->mcts->seed(this->random());
+        }
+        this->mcts->threads = this->threads;
+        this->mcts->outerStop = &this->stop;
+        this->mcts->biased = this->biasedPlayouts;
+
+        searchLimits limits;
+        limits.time = board.timeLimit;
+        limits.nodes = this->maxPlayouts;
+        if (this->verbose) {
+            std::cout << "Running playouts..." << std::endl;
+        }
+        this->lastSearch = this->mcts->search(board, this->color, limits);
+        bestMove = *legalMoves.find(this->lastSearch.move);
+
+        if (this->verbose) {
+            const searchResult &result = this->lastSearch;
+            std::cout << "\tPlayouts: " << result.nodes << " ("
+                << (long long) (result.nodes / std::max(result.time, 1e-6f))
+                << " per second)\t\tWin rate: "
+                << (result.score + 1000) / 20.0 << "%" << std::endl;
+        }
     }
     // 其他情况
     else {
         // 计算最大搜索深度
-        int maxDepth = 64 - board.discsOnBoard;
+        int maxDepth = boardSquares - board.discsOnBoard;
+        searchLimits limits;
+        limits.time = board.timeLimit;
+        limits.depth = this->maxDepth;
 
         // 如果最大深度小于10，则搜索到终端状态
         if (maxDepth < 10) {
-            // 搜索到终端状态
-            std::cout << "Searching remainder of game tree..." << std::endl;
-            std::cout << "\tSearching to depth " << maxDepth;
-
-            bestMove = this->depthLimitedAlphaBeta(board, maxDepth, startTime,
-                    board.timeLimit);
-
-            std::cout << "\t\tSearch complete." << std::endl;
+            limits.depth = maxDepth;
+            if (this->verbose) {
+                std::cout << "Searching remainder of game tree..." << std::endl;
+            }
         }
         // 否则，使用迭代加深搜索
-        else {
-            // 搜索游戏树
+        else if (this->verbose) {
             std::cout << "Searching game tree..." << std::endl;
+        }
 
-            // 迭代加深搜索
-            for (int depthLimit = 1; depthLimit <= maxDepth; depthLimit++) {
-                std::cout << "\tSearching to depth " << depthLimit;
-
-                move = this->depthLimitedAlphaBeta(board, depthLimit, startTime,
-                        board.timeLimit);
-
-                // 如果搜索被中止
-                if (move.first == -1) {
-                    std::cout << "\t\tSearch aborted." << std::endl;
-                    break;
-                }
-                // 否则，更新最佳移动
-                else {
-                    std::cout << "\t\tSearch complete." << std::endl;
-                    bestMove = move;
-                }
+        // 迭代加深搜索；每完成一层输出一行。若第一层也未能完成，
+        // analyze 返回第一个合法走法，因此不会走出非法的一步
+        othelloBoard root = board;
+        bool verbose = this->verbose;
+        searchResult result = this->analyze(root, limits,
+                [verbose](const searchResult &info) {
+                    if (verbose) {
+                        std::cout << "\tSearching to depth " << info.depth
+                            << "\t\tSearch complete." << std::endl;
+                    }
+                });
+        bestMove = *legalMoves.find(result.move);
+        this->lastSearch = result;
+    }
 
-                // 如果时间过半，则停止搜索
-                if (this->stopTimer(startTime) > 0.5*board.timeLimit) {
-                    break;
-                }
-            }
-        }
+    if (!this->verbose) {
+        return bestMove;
     }
 
     // 打印消耗时间
@@ -340,17 +275,615 @@ std::pair<int, std::list<int>> othelloPlayer::computerMove(othelloBoard &board,
         << std::endl;
 
     // 将索引转换为坐标并打印
-    int rowNum = 0, colNum = 0;
-    std::string colCoord = "ABCDEFGH";
-    std::string rowCoord = "12345678";
-    board.index2coord(bestMove.first, colNum, rowNum);
-    std::cout << "\tComputer takes: " << colCoord[colNum] << rowCoord[rowNum]
+    std::cout << "\tComputer takes: " << squareName(bestMove.first)
         << "\n" << std::endl;
 
     // 返回最佳移动
     return bestMove;
 }
 
+// Silent iterative deepening search used by tools and analysis front ends
+/**
+ * @brief 在给定限制下分析局面
+ *
+ * 与 computerMove 使用相同的迭代加深搜索，但不查询开局库、不输出任何信息。
+ * 如果没有任何一次迭代在时限内完成，则返回第一个合法走法，深度为 0。
+ *
+ * @param board 待分析的棋盘，轮到本玩家（this->color）走棋
+ * @param limits 搜索深度、时间与节点数限制，0 表示不限制；rootMoves 非空时只搜索其中的走法
+ * @param progress 每完成一次迭代时调用，可为空
+ * @return 搜索结果，包括最佳走法、分数、完成深度、节点数与耗时
+ */
+searchResult othelloPlayer::analyze(othelloBoard &board,
+        const searchLimits &limits,
+        std::function<void(const searchResult &)> progress) {
+    std::chrono::time_point<std::chrono::system_clock> startTime
+        = this->startTimer();
+    searchResult result;
+
+    int maxDepth = this->prepareRoot(board, limits, result);
+    if (maxDepth == 0) {
+        return result;
+    }
+    float timeLimit = (limits.time > 0)
+        ? limits.time : std::numeric_limits<float>::max();
+
+    // Root splitting: never more workers than root moves. Multi-PV
+    // searches run on this thread only.
+    bool multiPV = (limits.multiPV != 1);
+    int workers = multiPV ? 1
+        : std::max(1, std::min<int>(this->threads, board.moves.size()));
+    while ((int) this->helpers.size() < workers - 1) {
+        this->helpers.emplace_back(new othelloPlayer());
+        this->helpers.back()->master = this;
+        this->helpers.back()->seed(this->random());
+    }
+
+    this->nodes = 0;
+    // Every worker gets a share of at least one node, as 0 is no limit
+    this->nodeLimit = (limits.nodes > 0)
+        ? std::max(1LL, limits.nodes / workers) : 0;
+    for (int i = 0; i < workers - 1; i++) {
+        this->helpers[i]->color = this->color;
+        this->helpers[i]->heuristic.type = this->heuristic.type;
+        this->helpers[i]->table = this->table;
+        this->helpers[i]->endgameCache = this->endgameCache;
+        this->helpers[i]->nodes = 0;
+        this->helpers[i]->nodeLimit = this->nodeLimit;
+        this->helpers[i]->allocations = allocCounters();
+    }
+    if (multiPV && this->table == nullptr && !this->ownTable) {
+        this->ownTable.reset(new othelloTable(16 << 20));
+    }
+    if (this->table != nullptr) {
+        this->table->newSearch();
+    }
+    allocCounters startAllocations = threadAllocCounters();
+
+    // A solved root is answered from the endgame cache with the move stored
+    // alongside its score. Only plain searches of every root move to the
+    // end of the game score the root exactly.
+    int empties = boardSquares - board.discsOnBoard;
+    bool solving = !multiPV && limits.rootMoves.empty()
+        && maxDepth == empties;
+    if (solving && this->rootSolved(board, result)) {
+        result.nodes = this->totalNodes(workers);
+        result.time = this->stopTimer(startTime);
+        if (progress) {
+            progress(result);
+        }
+        return result;
+    }
+
+    for (int depthLimit = 1; depthLimit <= maxDepth; depthLimit++) {
+        bool complete = multiPV
+            ? this->multiPVIteration(board, limits.multiPV, depthLimit,
+                    startTime, timeLimit, result)
+            : (workers == 1)
+            ? this->searchIteration(board, depthLimit, startTime, timeLimit,
+                    result)
+            : this->parallelIteration(board, workers, depthLimit, startTime,
+                    timeLimit, result);
+        if (!complete) {
+            break;
+        }
+        result.depth = depthLimit;
+        if (solving && depthLimit == maxDepth) {
+            this->storeRoot(board, result);
+        }
+
+        if (progress) {
+            result.nodes = this->totalNodes(workers);
+            result.time = this->stopTimer(startTime);
+            progress(result);
+        }
+
+        if (limits.time > 0 && this->stopTimer(startTime) > 0.5*limits.time) {
+            break;
+        }
+    }
+
+    this->nodeLimit = 0;
+    result.nodes = this->totalNodes(workers);
+    result.time = this->stopTimer(startTime);
+    result.allocations = threadAllocCounters() - startAllocations;
+    for (int i = 0; i < workers - 1; i++) {
+        result.allocations += this->helpers[i]->allocations;
+    }
+    return result;
+}
+
+// Generates the root moves and returns the deepest iteration to search
+/**
+ * @brief 准备根节点
+ *
+ * 生成根走法并按 limits.rootMoves 过滤；有合法走法时 result 的走法先设为
+ * 第一个合法走法，以便第一次迭代未完成时仍能返回合法的一步。
+ *
+ * @param board 根局面，写入根走法
+ * @param limits 搜索限制
+ * @param result 写入默认走法
+ * @return 迭代加深的最大深度；没有合法走法时返回 0
+ */
+int othelloPlayer::prepareRoot(othelloBoard &board, const searchLimits &limits,
+        searchResult &result) {
+    board.findLegalMoves(this->color, &board.moves);
+    if (!limits.rootMoves.empty()) {
+        for (auto it = board.moves.begin(); it != board.moves.end(); ) {
+            if (std::find(limits.rootMoves.begin(), limits.rootMoves.end(),
+                        it->first) == limits.rootMoves.end()) {
+                it = board.moves.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+    }
+    if (board.moves.empty()) {
+        return 0;
+    }
+    result.move = board.moves.begin()->first;
+
+    int maxDepth = boardSquares - board.discsOnBoard;
+    if (limits.depth > 0 && limits.depth < maxDepth) {
+        maxDepth = limits.depth;
+    }
+    return maxDepth;
+}
+
+// Copies the best move, score and principal variation of the iteration
+// that just completed
+void othelloPlayer::collectResult(searchResult &result) {
+    result.move = this->bestMove->first;
+    result.score = this->nodeStack[0].score;
+    result.pv.assign(this->nodeStack[0].pv.begin(),
+            this->nodeStack[0].pv.begin() + this->nodeStack[0].pvLength);
+}
+
+// Runs one iteration of iterative deepening on this player's stack
+/**
+ * @brief 单线程完成一次迭代
+ *
+ * @param board 根局面，board.moves 为要搜索的根走法
+ * @param depthLimit 本次迭代的深度
+ * @param startTime 搜索开始时间
+ * @param timeLimit 时间限制（秒）
+ * @param result 迭代完成时写入最佳走法、分数与主要变例
+ * @return 迭代完成时返回 true，超时或被中止时返回 false
+ */
+bool othelloPlayer::searchIteration(othelloBoard &board, int depthLimit,
+        std::chrono::time_point<std::chrono::system_clock> startTime,
+        float timeLimit, searchResult &result) {
+    std::pair<int, std::list<int>> move = this->depthLimitedAlphaBeta(board,
+            depthLimit, startTime, timeLimit);
+    if (move.first == -1) {
+        return false;
+    }
+
+    this->collectResult(result);
+    return true;
+}
+
+// Splits the root moves over this player and its helpers
+/**
+ * @brief 根节点分割的并行迭代
+ *
+ * 将根走法轮流分配给本玩家与 workers-1 个辅助搜索器，各自在独立的节点栈上
+ * 同时搜索到 depthLimit，最后取分数最高的结果。任一部分未完成则整次迭代作废。
+ *
+ * @param board 根局面
+ * @param workers 参与搜索的线程数
+ * @param depthLimit 本次迭代的深度
+ * @param startTime 搜索开始时间
+ * @param timeLimit 时间限制（秒）
+ * @param result 迭代完成时写入最佳走法、分数与主要变例
+ * @return 所有部分都完成时返回 true
+ */
+bool othelloPlayer::parallelIteration(othelloBoard &board, int workers,
+        int depthLimit,
+        std::chrono::time_point<std::chrono::system_clock> startTime,
+        float timeLimit, searchResult &result) {
+    std::vector<othelloBoard> shares(workers, board);
+    int i = 0;
+    for (auto keyval : board.moves) {
+        for (int w = 0; w < workers; w++) {
+            if (w != i % workers) {
+                shares[w].moves.erase(keyval.first);
+            }
+        }
+        i++;
+    }
+
+    std::vector<searchResult> partial(workers);
+    std::vector<char> complete(workers, false);
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; w++) {
+        threads.emplace_back([&, w]() {
+            allocCounters start = threadAllocCounters();
+            complete[w] = this->helpers[w-1]->searchIteration(shares[w],
+                    depthLimit, startTime, timeLimit, partial[w]);
+            this->helpers[w-1]->allocations += threadAllocCounters() - start;
+        });
+    }
+    complete[0] = this->searchIteration(shares[0], depthLimit, startTime,
+            timeLimit, partial[0]);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    int best = -1;
+    for (int w = 0; w < workers; w++) {
+        if (!complete[w]) {
+            return false;
+        }
+        if (best == -1 || partial[w].score > partial[best].score) {
+            best = w;
+        }
+    }
+
+    result.move = partial[best].move;
+    result.score = partial[best].score;
+    result.pv = partial[best].pv;
+    return true;
+}
+
+// Scores every root move in one iteration, sharing work through the table
+/**
+ * @brief 多主要变例迭代
+ *
+ * 按上一次迭代的分数从高到低逐个搜索根走法，所有走法共用置换表。已有 count
+ * 个精确分数后，以其中第 count 高的分数作为根节点的 alpha，分数更低的走法
+ * 只得到上界，因此搜索量远小于 count 次独立搜索。
+ *
+ * @param board 根局面
+ * @param count 需要精确分数的走法数，0 表示全部
+ * @param depthLimit 本次迭代的深度
+ * @param startTime 搜索开始时间
+ * @param timeLimit 时间限制（秒）
+ * @param result 迭代完成时写入所有根走法及最佳走法
+ * @return 迭代完成时返回 true
+ */
+bool othelloPlayer::multiPVIteration(othelloBoard &board, int count,
+        int depthLimit,
+        std::chrono::time_point<std::chrono::system_clock> startTime,
+        float timeLimit, searchResult &result) {
+    othelloTable *shared = this->table;
+    if (shared == nullptr) {
+        this->table = this->ownTable.get();
+    }
+    // Scores reported as exact must not carry the prune adjustment
+    this->pruneAdjustment = 0;
+
+    // Best moves of the previous iteration first
+    std::vector<int> order;
+    for (const searchLine &line : result.lines) {
+        order.push_back(line.move);
+    }
+    for (auto keyval : board.moves) {
+        if (std::find(order.begin(), order.end(), keyval.first) == order.end()) {
+            order.push_back(keyval.first);
+        }
+    }
+
+    std::vector<searchLine> lines;
+    std::vector<int> exactScores;
+    bool complete = true;
+    for (int move : order) {
+        othelloBoard root = board;
+        for (auto it = root.moves.begin(); it != root.moves.end(); ) {
+            it = (it->first == move) ? std::next(it) : root.moves.erase(it);
+        }
+
+        int alpha = INT_MIN;
+        if (count > 0 && (int) exactScores.size() >= count) {
+            std::sort(exactScores.begin(), exactScores.end(),
+                    std::greater<int>());
+            alpha = exactScores[count - 1];
+        }
+
+        this->beginIteration(root, depthLimit, alpha);
+        if (this->continueIteration(0, startTime, timeLimit)
+                != iterationStatus::complete) {
+            complete = false;
+            break;
+        }
+
+        searchLine line;
+        line.move = move;
+        line.score = this->nodeStack[0].score;
+        line.bound = (line.score > alpha) ? boundType::exact : boundType::upper;
+        line.pv.assign(this->nodeStack[0].pv.begin(),
+                this->nodeStack[0].pv.begin() + this->nodeStack[0].pvLength);
+        if (line.bound == boundType::exact) {
+            exactScores.push_back(line.score);
+        }
+        lines.push_back(line);
+    }
+
+    this->table = shared;
+    this->pruneAdjustment = 1;
+    if (!complete) {
+        return false;
+    }
+
+    std::stable_sort(lines.begin(), lines.end(),
+            [](const searchLine &a, const searchLine &b) {
+                return a.score > b.score;
+            });
+    result.move = lines[0].move;
+    result.score = lines[0].score;
+    result.pv = lines[0].pv;
+    result.lines = lines;
+    return true;
+}
+
+// Nodes searched by this player and the helpers in use
+long long othelloPlayer::totalNodes(int workers) {
+    long long total = this->nodes;
+    for (int i = 0; i < workers - 1; i++) {
+        total += this->helpers[i]->nodes;
+    }
+    return total;
+}
+
+// Copies the child's principal variation behind the move just searched
+/**
+ * @brief 更新主要变例
+ *
+ * 节点采用某个子节点的分数时调用：主要变例为刚搜索的走法加上子节点的主要变例。
+ *
+ * @param depth 分数被更新的节点深度
+ * @param leaf 子节点是否为叶节点（叶节点没有后续变例）
+ */
+void othelloPlayer::updatePV(int depth, bool leaf) {
+    node &parent = this->nodeStack[depth];
+    parent.pv[0] = parent.prevIterator->first;
+    parent.pvLength = 1;
+
+    if (!leaf) {
+        node &child = this->nodeStack[depth+1];
+        std::copy(child.pv.begin(), child.pv.begin() + child.pvLength,
+                parent.pv.begin() + 1);
+        parent.pvLength += child.pvLength;
+    }
+}
+
+// Cuts the node just pushed short if the table already knows its value
+/**
+ * @brief 查询置换表
+ *
+ * 在弃权处理之后调用。表项的搜索深度不小于剩余深度，且分数为精确值或足以
+ * 在当前窗口内截断时，节点直接采用表中分数并清空走法，随后按已搜索完毕出栈。
+ * 搜索到终局的节点先查询残局缓存。
+ *
+ * @param depth 刚入栈的节点深度
+ */
+void othelloPlayer::probeTable(int depth) {
+    node &current = this->nodeStack[depth];
+    uint64_t prefetched = current.key;
+    current.key = 0;
+    current.endgameKey = 0;
+    current.alphaEntry = current.alpha;
+    current.betaEntry = current.beta;
+    // Finished games are already scored
+    if (current.board.moves.empty()) {
+        return;
+    }
+
+    int toMove = current.isMaxNode ? this->color : -this->color;
+    if (this->probeEndgameCache(depth, toMove) || this->table == nullptr) {
+        return;
+    }
+
+    // The key was computed when the move was made, for the side that was
+    // to move before any pass
+    bool passed = (current.isMaxNode == this->nodeStack[depth-1].isMaxNode);
+    uint64_t key = passed ? othelloTable::hash(current.board, toMove,
+            this->color, this->heuristic.type) : prefetched;
+    tableEntry entry;
+    if (this->table->probe(key, entry)
+            && entry.depth >= this->depthLimit - depth
+            && this->usableEntry(entry, depth)) {
+        current.score = entry.score;
+        current.board.moves.clear();
+        if (entry.move >= 0) {
+            current.pv[0] = entry.move;
+            current.pvLength = 1;
+        }
+        return;
+    }
+
+    current.key = key;
+}
+
+// Records the score of a node whose search is finished
+/**
+ * @brief 写入置换表
+ *
+ * 分数不高于进入时的 alpha 为上界，不低于进入时的 beta 为下界，否则为精确值。
+ * 上下界按 pruneAdjustment 放宽一个单位。
+ *
+ * @param depth 即将出栈的节点深度
+ */
+void othelloPlayer::storeTable(int depth) {
+    const node &current = this->nodeStack[depth];
+    if (depth == 0) {
+        return;
+    }
+
+    if (current.endgameKey != 0) {
+        this->storeEndgameCache(depth,
+                current.isMaxNode ? this->color : -this->color);
+    }
+    if (this->table == nullptr || current.key == 0) {
+        return;
+    }
+
+    // A bound taken from a cut-off child carries that child's score moved by
+    // pruneAdjustment, one unit tighter than the child proves: widen it back
+    // before other searches reuse it
+    tableEntry entry;
+    entry.score = current.score;
+    entry.depth = this->depthLimit - depth;
+    entry.bound = (current.score <= current.alphaEntry) ? boundType::upper
+        : (current.score >= current.betaEntry) ? boundType::lower
+        : boundType::exact;
+    if (entry.bound == boundType::upper && entry.score < INT_MAX) {
+        entry.score += this->pruneAdjustment;
+    }
+    else if (entry.bound == boundType::lower && entry.score > INT_MIN) {
+        entry.score -= this->pruneAdjustment;
+    }
+    entry.move = (current.pvLength > 0) ? current.pv[0] : -1;
+    this->table->store(current.key, entry);
+}
+
+bool othelloPlayer::usableEntry(const tableEntry &entry, int depth) const {
+    const node &current = this->nodeStack[depth];
+    return entry.bound == boundType::exact
+        || (entry.bound == boundType::lower && entry.score >= current.beta)
+        || (entry.bound == boundType::upper && entry.score <= current.alpha);
+}
+
+// Looks up a node whose search reaches the end of the game
+/**
+ * @brief 查询残局缓存
+ *
+ * 只有剩余深度不小于空格数（每步棋都会填一个空格，弃权不消耗深度），即叶节点
+ * 全部为终局的节点才使用缓存，其分数与迭代深度和估值函数无关。缓存中的子数差
+ * 以走棋方计，换算为本玩家视角的搜索分数，界的方向随之翻转。
+ *
+ * @param depth 刚入栈的节点深度
+ * @param toMove 该节点轮到走棋的一方
+ * @return 缓存结果可以直接作为节点分数时返回 true
+ */
+bool othelloPlayer::probeEndgameCache(int depth, int toMove) {
+    node &current = this->nodeStack[depth];
+    int empties = boardSquares - current.board.discsOnBoard;
+    if (this->endgameCache == nullptr || this->depthLimit - depth < empties
+            || empties < this->endgameCache->minEmpties) {
+        return false;
+    }
+
+    int symmetry = 0;
+    uint64_t key = othelloEndgameCache::hash(current.board, toMove, symmetry);
+    tableEntry entry;
+    if (this->endgameCache->probe(key, symmetry, entry)) {
+        if (toMove != this->color) {
+            entry.score = -entry.score;
+            entry.bound = (entry.bound == boundType::lower) ? boundType::upper
+                : (entry.bound == boundType::upper) ? boundType::lower
+                : entry.bound;
+        }
+        entry.score *= othelloHeuristic::terminalWeight;
+        if (this->usableEntry(entry, depth)) {
+            current.score = entry.score;
+            current.board.moves.clear();
+            if (entry.move >= 0) {
+                current.pv[0] = entry.move;
+                current.pvLength = 1;
+            }
+            return true;
+        }
+    }
+
+    current.endgameKey = key;
+    current.endgameSymmetry = symmetry;
+    return false;
+}
+
+// Stores the solved node about to be popped, as a disc difference from the
+// side to move
+void othelloPlayer::storeEndgameCache(int depth, int toMove) {
+    const node &current = this->nodeStack[depth];
+    // Every leaf below the node is a finished game, so the score is a
+    // multiple of terminalWeight, give or take the prune adjustments
+    if (std::abs(current.score) > boardSquares*othelloHeuristic::terminalWeight) {
+        return;
+    }
+
+    tableEntry entry;
+    entry.score = othelloHeuristic::discScore(current.score);
+    entry.bound = (current.score <= current.alphaEntry) ? boundType::upper
+        : (current.score >= current.betaEntry) ? boundType::lower
+        : boundType::exact;
+    entry.move = (current.pvLength > 0) ? current.pv[0] : -1;
+    if (toMove != this->color) {
+        entry.score = -entry.score;
+        entry.bound = (entry.bound == boundType::lower) ? boundType::upper
+            : (entry.bound == boundType::upper) ? boundType::lower
+            : entry.bound;
+    }
+    this->endgameCache->store(current.endgameKey, current.endgameSymmetry,
+            entry);
+}
+
+// Looks up the exact result of the root, for this player
+/**
+ * @brief 从残局缓存读取已解出的根节点
+ *
+ * 只接受精确分数，且与分数一同保存的走法必须是当前的根走法之一，否则视为
+ * 未解出，重新搜索。
+ *
+ * @param board 根局面，board.moves 为根走法
+ * @param result 命中时写入走法、分数、深度与主要变例
+ * @return 命中时返回 true
+ */
+bool othelloPlayer::rootSolved(const othelloBoard &board,
+        searchResult &result) {
+    int empties = boardSquares - board.discsOnBoard;
+    if (this->endgameCache == nullptr
+            || empties < this->endgameCache->minEmpties) {
+        return false;
+    }
+
+    int symmetry = 0;
+    uint64_t key = othelloEndgameCache::hash(board, this->color, symmetry);
+    tableEntry entry;
+    if (!this->endgameCache->probe(key, symmetry, entry)
+            || entry.bound != boundType::exact
+            || board.moves.find(entry.move) == board.moves.end()) {
+        return false;
+    }
+
+    result.move = entry.move;
+    result.score = entry.score*othelloHeuristic::terminalWeight;
+    result.depth = empties;
+    result.pv.assign(1, entry.move);
+    return true;
+}
+
+void othelloPlayer::storeRoot(const othelloBoard &board,
+        const searchResult &result) {
+    int empties = boardSquares - board.discsOnBoard;
+    if (this->endgameCache == nullptr
+            || empties < this->endgameCache->minEmpties) {
+        return;
+    }
+
+    int symmetry = 0;
+    uint64_t key = othelloEndgameCache::hash(board, this->color, symmetry);
+    tableEntry entry;
+    entry.score = othelloHeuristic::discScore(result.score);
+    entry.bound = boundType::exact;
+    entry.move = result.move;
+    this->endgameCache->store(key, symmetry, entry);
+}
+
+othelloPlayer::othelloPlayer() {
+}
+
+othelloPlayer::~othelloPlayer() {
+}
+
+void othelloPlayer::setEvaluator(evaluatorType type) {
+    this->heuristic.type = type;
+}
+
+void othelloPlayer::seed(unsigned value) {
+    this->random.seed(value);
+}
+
 // Returns time point
 /**
  * @brief 开始计时
@@ -407,22 +940,81 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
         othelloBoard &board, int depthLimit,
         std::chrono::time_point<std::chrono::system_clock> startTime,
         float timeLimit) {
+    this->beginIteration(board, depthLimit);
+    if (this->continueIteration(0, startTime, timeLimit)
+            != iterationStatus::complete) {
+        std::pair<int, std::list<int>> move;
+        move.first = -1;
+        return move;
+    }
+
+    return *this->bestMove;
+}
 
+// Sets up the node stack for one iteration of depthLimitedAlphaBeta
+/**
+ * @brief 初始化一次深度受限搜索
+ *
+ * 所有搜索状态都保存在节点栈与成员变量中，因此搜索可以分多次继续。
+ *
+ * @param board 根局面，board.moves 为要搜索的根走法
+ * @param depthLimit 搜索的最大深度
+ * @param alpha 根节点的初始 alpha；低于它的根分数只是上界
+ */
+void othelloPlayer::beginIteration(othelloBoard &board, int depthLimit,
+        int alpha) {
     // 初始化根节点
     // Initialize root node
     this->nodeStack[0].isMaxNode = true;
-    this->nodeStack[0].alpha = INT_MIN;
+    this->nodeStack[0].alpha = alpha;
     this->nodeStack[0].beta = INT_MAX;
     this->nodeStack[0].score = INT_MIN;
     this->nodeStack[0].board = board;
     this->nodeStack[0].moveIterator = this->nodeStack[0].board.moves.begin();
     this->nodeStack[0].prevIterator = this->nodeStack[0].moveIterator;
     this->nodeStack[0].lastMove = this->nodeStack[0].board.moves.end();
+    // Children of a depth-one search are never pushed, so make sure a stale
+    // score from a previous search cannot leak into the root
+    this->nodeStack[1].score = INT_MIN;
+    this->nodeStack[0].pvLength = 0;
+    this->nodeStack[1].pvLength = 0;
 
-    int depth = 0;
-    int leafScore = 0;
-    std::unordered_map<int, std::list<int>>::iterator bestMove =
-        this->nodeStack[0].board.moves.begin();
+    this->stackDepth = 0;
+    this->depthLimit = depthLimit;
+    this->bestMove = this->nodeStack[0].board.moves.begin();
+}
+
+// Runs the iteration set up by beginIteration for at most budget nodes
+/**
+ * @brief 继续当前的深度受限搜索
+ *
+ * @param budget 本次最多搜索的节点数，0 表示不限制
+ * @param startTime 搜索开始时间
+ * @param timeLimit 搜索的最大时间限制（秒）
+ * @return 搜索完成、因节点预算暂停，或因超时、超出节点限制、被中止而失败
+ */
+othelloPlayer::iterationStatus othelloPlayer::continueIteration(
+        long long budget,
+        std::chrono::time_point<std::chrono::system_clock> startTime,
+        float timeLimit) {
+    return (this->color == 1)
+        ? this->continueIterationAs<1>(budget, startTime, timeLimit)
+        : this->continueIterationAs<-1>(budget, startTime, timeLimit);
+}
+
+// continueIteration for the searching color searcher, known at compile time
+// so that moves are generated, made and evaluated by the versions of the
+// board and heuristic for each side
+template <int searcher>
+othelloPlayer::iterationStatus othelloPlayer::continueIterationAs(
+        long long budget,
+        std::chrono::time_point<std::chrono::system_clock> startTime,
+        float timeLimit) {
+    int &depth = this->stackDepth;
+    int depthLimit = this->depthLimit;
+    std::unordered_map<int, std::list<int>>::iterator &bestMove =
+        this->bestMove;
+    long long sliceEnd = this->nodes + budget;
 
     // 当尚未评估根节点的所有子节点时
     // While we have not evaluated all the root's children
@@ -431,12 +1023,12 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
         // If we have evaluated all children
         if (this->nodeStack[depth].moveIterator
                 == this->nodeStack[depth].lastMove) {
+            this->storeTable(depth);
             if (depth-- == 0) {
-                if (this->nodeStack[1].score > this->nodeStack[0].score
-                        || (this->nodeStack[1].score == this->nodeStack[0].score
-                            && rand() % 2 == 0)) {
+                if (this->nodeStack[1].score > this->nodeStack[0].score) {
                     this->nodeStack[0].score = this->nodeStack[1].score;
                     bestMove = this->nodeStack[0].prevIterator;
+                    this->updatePV(0, false);
                 }
 
                 if (this->nodeStack[0].score > this->nodeStack[0].alpha) {
@@ -447,10 +1039,15 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
             }
 
             if (this->nodeStack[depth].isMaxNode) {
+                // Ties are broken at random below the root only: a root
+                // move that ties the best score failed low, and its score
+                // is only an upper bound
                 if (this->nodeStack[depth+1].score > this->nodeStack[depth].score
-                        || (this->nodeStack[depth+1].score == this->nodeStack[depth].score
-                            && rand() % 2 == 0)) {
+                        || (depth > 0
+                            && this->nodeStack[depth+1].score == this->nodeStack[depth].score
+                            && (this->random() & 1) == 0)) {
                     this->nodeStack[depth].score = this->nodeStack[depth+1].score;
+                    this->updatePV(depth, false);
                     if (depth == 0) {
                         bestMove = this->nodeStack[0].prevIterator;
                     }
@@ -463,6 +1060,7 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
             else {
                 if (this->nodeStack[depth+1].score < this->nodeStack[depth].score) {
                     this->nodeStack[depth].score = this->nodeStack[depth+1].score;
+                    this->updatePV(depth, false);
                 }
 
                 if (this->nodeStack[depth].score < this->nodeStack[depth].beta) {
@@ -473,12 +1071,12 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
         // 如果可以剪枝
         // If we can prune
         else if (this->nodeStack[depth].beta <= this->nodeStack[depth].alpha) {
+            this->storeTable(depth);
             if (depth-- == 0) {
-                if (this->nodeStack[1].score > this->nodeStack[0].score
-                    || (this->nodeStack[1].score == this->nodeStack[0].score
-                        && rand() % 2 == 0)) {
+                if (this->nodeStack[1].score > this->nodeStack[0].score) {
                     this->nodeStack[0].score = this->nodeStack[1].score;
                     bestMove = this->nodeStack[0].prevIterator;
+                    this->updatePV(0, false);
                 }
 
                 if (this->nodeStack[0].score > this->nodeStack[0].alpha) {
@@ -493,9 +1091,12 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
 
             if (this->nodeStack[depth].isMaxNode) {
                 if (this->nodeStack[depth+1].score > this->nodeStack[depth].score
-                    || (this->nodeStack[depth+1].score == this->nodeStack[depth].score
-                        && rand() % 2 == 0)) {
-                    this->nodeStack[depth].score = this->nodeStack[depth+1].score - 1;
+                    || (depth > 0
+                        && this->nodeStack[depth+1].score == this->nodeStack[depth].score
+                        && (this->random() & 1) == 0)) {
+                    this->nodeStack[depth].score = this->nodeStack[depth+1].score
+                        - this->pruneAdjustment;
+                    this->updatePV(depth, false);
                     if (depth == 0) {
                         bestMove = this->nodeStack[0].prevIterator;
                     }
@@ -510,7 +1111,9 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
             }
             else {
                 if (this->nodeStack[depth+1].score < this->nodeStack[depth].score) {
-                    this->nodeStack[depth].score = this->nodeStack[depth+1].score + 1;
+                    this->nodeStack[depth].score = this->nodeStack[depth+1].score
+                        + this->pruneAdjustment;
+                    this->updatePV(depth, false);
                 }
 
                 if (this->nodeStack[depth].score < this->nodeStack[depth].beta) {
@@ -518,95 +1121,173 @@ std::pair<int, std::list<int>> othelloPlayer::depthLimitedAlphaBeta(
                 }
             }
         }
+        // 生成下一个节点：按走棋方分派到专门化的版本
+        // Generate next node, by the version for the side to move
+        else if (this->nodeStack[depth].isMaxNode) {
+            this->searchNextMove<searcher, searcher>(depth, depthLimit);
+        }
         else {
-            // 生成下一个节点，增加迭代器
-            // Generate next node, increment iterators
-            this->nodeStack[depth+1].board = this->nodeStack[depth].board;
-            this->nodeStack[depth+1].board.updateBoard(
-                    (this->nodeStack[depth].isMaxNode ? this->color : -this->color),
-                    *this->nodeStack[depth].moveIterator);
-            this->nodeStack[depth].prevIterator = this->nodeStack[depth].moveIterator;
-            this->nodeStack[depth].moveIterator++;
-
-            // 如果下一个深度未达到深度限制
-            // If the next depth is not at the depth limit
-            if (depth + 1 < depthLimit) {
-                depth++;
-
-                // 初始化栈中的下一个节点
-                // Initialize next node in stack
-                this->nodeStack[depth].isMaxNode = !this->nodeStack[depth-1].isMaxNode;
-                this->nodeStack[depth].score =
-                    (this->nodeStack[depth].isMaxNode ? INT_MIN : INT_MAX);
-                this->nodeStack[depth].alpha = this->nodeStack[depth-1].alpha;
-                this->nodeStack[depth].beta = this->nodeStack[depth-1].beta;
-                this->nodeStack[depth].board.findLegalMoves(
-                        (this->nodeStack[depth].isMaxNode ? this->color : -this->color),
-                        &this->nodeStack[depth].board.moves);
-
-                /*
-                std::unordered_map<int, std::list<int>> foo1
-                    = this->nodeStack[depth].board.moves.find(this->killerMoves[depth][0]);
-                std::unordered_map<int, std::list<int>> foo2
-                    = this->nodeStack[depth].board.moves.find(this->killerMoves[depth][1]);
-
-                if (foo1 != this->nodeStack[depth].lastMove
-                    && foo2 != this->nodeStack[depth].lastMove) {
-                    std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo1);
-                    std::iter_swap(std::next(this->nodeStack[depth].board.moves.begin()), foo2);
-                }
-                else if (foo1 != this->nodeStack[depth].lastMove) {
-                    std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo1);
-                }
-                else if (foo2 != this->nodeStack[depth].lastMove) {
-                    std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo2);
-                }
-                */
+            this->searchNextMove<searcher, -searcher>(depth, depthLimit);
+        }
+
+        // 如果时间即将耗尽、节点数超限或被要求停止，则失败
+        // If we are almost out of time, over the node budget or asked to
+        // stop, failure
+        if (this->stopTimer(startTime) > 0.998*timeLimit
+                || (this->nodeLimit > 0 && this->nodes >= this->nodeLimit)
+                || this->stop.load(std::memory_order_relaxed)
+                || (this->master != nullptr
+                    && this->master->stop.load(std::memory_order_relaxed))) {
+            return iterationStatus::aborted;
+        }
 
-                this->nodeStack[depth].moveIterator =
-                    this->nodeStack[depth].board.moves.begin();
-                this->nodeStack[depth].prevIterator =
-                    this->nodeStack[depth].moveIterator;
-                this->nodeStack[depth].lastMove = this->nodeStack[depth].board.moves.end();
+        // 本次的节点预算用完，保留节点栈以便继续
+        // Out of budget for this slice: the node stack is kept for later
+        if (budget > 0 && this->nodes >= sliceEnd) {
+            return iterationStatus::paused;
+        }
+    }
+
+    return iterationStatus::complete;
+}
+
+// Makes the next move of the node at depth, where mover is to move, and
+// pushes the child or scores it as a leaf
+/**
+ * @brief 搜索节点的下一个走法
+ *
+ * continueIterationAs 中与走棋方有关的部分。走棋方 mover 在编译期已知，
+ * 因此走子、哈希、生成走法与叶节点更新都不再按节点类型分支。
+ *
+ * @param depth 当前节点深度；子节点入栈时加一
+ * @param depthLimit 本次迭代的深度
+ */
+template <int searcher, int mover>
+void othelloPlayer::searchNextMove(int &depth, int depthLimit) {
+    // 生成下一个节点，增加迭代器
+    // Generate next node, increment iterators
+    {
+        ALLOC_SCOPE(allocSite::boardCopy);
+        this->nodeStack[depth+1].board = this->nodeStack[depth].board;
+        this->nodeStack[depth+1].board.updateBoard<mover>(
+                *this->nodeStack[depth].moveIterator);
+    }
+    this->nodeStack[depth+1].board.discsOnBoard++;
+    // Hash the child as soon as it exists, so that its table slot
+    // is on its way into the cache while its moves are generated
+    if (this->table != nullptr && depth + 1 < depthLimit) {
+        node &child = this->nodeStack[depth+1];
+        child.key = othelloTable::hash(child.board, -mover, searcher,
+                this->heuristic.type);
+        this->table->prefetch(child.key);
+    }
+    this->nodeStack[depth].prevIterator = this->nodeStack[depth].moveIterator;
+    this->nodeStack[depth].moveIterator++;
+    this->nodes++;
+
+    // 如果下一个深度未达到深度限制
+    // If the next depth is not at the depth limit
+    if (depth + 1 < depthLimit) {
+        depth++;
+
+        // 初始化栈中的下一个节点
+        // Initialize next node in stack
+        this->nodeStack[depth].isMaxNode = (mover != searcher);
+        this->nodeStack[depth].score =
+            (mover != searcher) ? INT_MIN : INT_MAX;
+        this->nodeStack[depth].alpha = this->nodeStack[depth-1].alpha;
+        this->nodeStack[depth].beta = this->nodeStack[depth-1].beta;
+        this->nodeStack[depth].pvLength = 0;
+        {
+            ALLOC_SCOPE(allocSite::moveGeneration);
+            othelloBoard &child = this->nodeStack[depth].board;
+            child.findLegalMoves<-mover>(&child.moves);
+        }
+
+        // 无子可下时弃权：该节点改由对方走棋；双方都无子可下时
+        // 按终局叶节点评估
+        // A side with no legal moves passes: the node becomes the
+        // opponent's, at the same depth. If neither side can move,
+        // the game is over and the node is scored as a leaf.
+        if (this->nodeStack[depth].board.moves.empty()) {
+            othelloBoard &leaf = this->nodeStack[depth].board;
+            {
+                ALLOC_SCOPE(allocSite::moveGeneration);
+                leaf.findLegalMoves<mover>(&leaf.moves);
+            }
+            if (leaf.moves.empty()) {
+                ALLOC_SCOPE(allocSite::heuristic);
+                leaf.passes[0] = true;
+                leaf.passes[1] = true;
+                this->nodeStack[depth].score =
+                    this->heuristic.evaluate<searcher>(leaf);
             }
             else {
-                // 节点为叶节点：评估启发式函数并更新值
-                // The node is a leaf: evaluate heuristic and update values
-                leafScore = this->heuristic.evaluate(
-                        this->nodeStack[depth+1].board, this->color);
-
-                if (this->nodeStack[depth].isMaxNode) {
-                    if (leafScore > this->nodeStack[depth].score) {
-                        this->nodeStack[depth].score = leafScore;
-                        if (depth == 0) {
-                            bestMove = this->nodeStack[0].prevIterator;
-                        }
-                    }
+                this->nodeStack[depth].isMaxNode = (mover == searcher);
+                this->nodeStack[depth].score =
+                    (mover == searcher) ? INT_MIN : INT_MAX;
+            }
+        }
 
-                    if (this->nodeStack[depth].score > this->nodeStack[depth].alpha) {
-                        this->nodeStack[depth].alpha = this->nodeStack[depth].score;
-                    }
-                }
-                else {
-                    if (leafScore < this->nodeStack[depth].score) {
-                        this->nodeStack[depth].score = leafScore;
-                    }
+        /*
+        std::unordered_map<int, std::list<int>> foo1
+            = this->nodeStack[depth].board.moves.find(this->killerMoves[depth][0]);
+        std::unordered_map<int, std::list<int>> foo2
+            = this->nodeStack[depth].board.moves.find(this->killerMoves[depth][1]);
 
-                    if (this->nodeStack[depth].score < this->nodeStack[depth].beta) {
-                        this->nodeStack[depth].beta = this->nodeStack[depth].score;
-                    }
+        if (foo1 != this->nodeStack[depth].lastMove
+            && foo2 != this->nodeStack[depth].lastMove) {
+            std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo1);
+            std::iter_swap(std::next(this->nodeStack[depth].board.moves.begin()), foo2);
+        }
+        else if (foo1 != this->nodeStack[depth].lastMove) {
+            std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo1);
+        }
+        else if (foo2 != this->nodeStack[depth].lastMove) {
+            std::iter_swap(this->nodeStack[depth].board.moves.begin(), foo2);
+        }
+        */
+
+        this->probeTable(depth);
+
+        this->nodeStack[depth].moveIterator =
+            this->nodeStack[depth].board.moves.begin();
+        this->nodeStack[depth].prevIterator =
+            this->nodeStack[depth].moveIterator;
+        this->nodeStack[depth].lastMove = this->nodeStack[depth].board.moves.end();
+    }
+    else {
+        // 节点为叶节点：评估启发式函数并更新值
+        // The node is a leaf: evaluate heuristic and update values
+        int leafScore;
+        {
+            ALLOC_SCOPE(allocSite::heuristic);
+            leafScore = this->heuristic.evaluate<searcher>(
+                    this->nodeStack[depth+1].board);
+        }
+
+        if constexpr (mover == searcher) {
+            if (leafScore > this->nodeStack[depth].score) {
+                this->nodeStack[depth].score = leafScore;
+                this->updatePV(depth, true);
+                if (depth == 0) {
+                    this->bestMove = this->nodeStack[0].prevIterator;
                 }
             }
+
+            if (this->nodeStack[depth].score > this->nodeStack[depth].alpha) {
+                this->nodeStack[depth].alpha = this->nodeStack[depth].score;
+            }
         }
+        else {
+            if (leafScore < this->nodeStack[depth].score) {
+                this->nodeStack[depth].score = leafScore;
+                this->updatePV(depth, true);
+            }
 
-        // 如果时间即将耗尽，则失败
-        // If we are almost out of time, failure
-        if (this->stopTimer(startTime) > 0.998*timeLimit) {
-            std::pair<int, std::list<int>> move;
-            move.first = -1;
-            return move;
+            if (this->nodeStack[depth].score < this->nodeStack[depth].beta) {
+                this->nodeStack[depth].beta = this->nodeStack[depth].score;
+            }
         }
     }
-
-    return *bestMove;
 }
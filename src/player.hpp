@@ -3,23 +3,122 @@
 
 #include <string>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <climits>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
 #include <sstream>
+#include "allocstats.hpp"
 #include "database.hpp"
+#include "endgame.hpp"
 #include "heuristic.hpp"
+#include "table.hpp"
+
+// Limits for a silent analysis search. A limit of zero is no limit.
+struct searchLimits {
+    int depth = 0;
+    float time = 0.0;
+    long long nodes = 0;
+    // If not empty, only these root moves are searched
+    std::vector<int> rootMoves;
+    // Root moves to score exactly, best first; 0 for every legal move
+    int multiPV = 1;
+};
+
+// One root move of a multi-PV search. Moves outside the best multiPV only
+// get an upper bound.
+struct searchLine {
+    int move = -1;
+    int score = 0;
+    boundType bound = boundType::exact;
+    std::vector<int> pv;
+};
+
+// Outcome of an analysis search. score is from the point of view of the
+// searching player, and depth is the deepest completed iteration.
+struct searchResult {
+    int move = -1;
+    int score = 0;
+    int depth = 0;
+    long long nodes = 0;
+    float time = 0.0;
+    // Principal variation, starting with move
+    std::vector<int> pv;
+    // Every root move, best first, when limits.multiPV is not 1
+    std::vector<searchLine> lines;
+    // Heap allocations made by the search; zero unless the build counts
+    // them (see allocstats.hpp)
+    allocCounters allocations;
+};
+
+class othelloMCTS;
+
+// Search behind computerMove: iterative deepening alpha-beta, or Monte-Carlo
+// tree search (see mcts.hpp)
+enum class searchAlgorithm {alphaBeta, mcts};
 
 class othelloPlayer {
     public:
+        othelloPlayer();
+        ~othelloPlayer();
+
         int color;
         bool computer;
 
+        // Console output from computerMove; tools and tournaments turn it off
+        bool verbose = true;
+        // Whether computerMove takes moves from the opening book
+        bool useBook = true;
+        // Depth limit for computerMove; 0 for none (time limit only)
+        int maxDepth = 0;
+        // Threads used to search the root moves in parallel
+        int threads = 1;
+        // Transposition table shared with other searchers, or nullptr.
+        // Helpers use the same table.
+        othelloTable *table = nullptr;
+        // Solved endgames shared with other searches and processes, or
+        // nullptr. Probed and stored by nodes searched to the end of the
+        // game.
+        othelloEndgameCache *endgameCache = nullptr;
+
+        // Search used by computerMove. With mcts, the time limit of the
+        // board and maxPlayouts (0 for none) bound each move, and playouts
+        // take corners first if biasedPlayouts is set.
+        searchAlgorithm algorithm = searchAlgorithm::alphaBeta;
+        long long maxPlayouts = 0;
+        bool biasedPlayouts = false;
+        // Result of the last search run by computerMove; empty (no nodes)
+        // for book moves, forced moves and passes
+        searchResult lastSearch;
+
         // Driver for moves, regardless of player
         std::pair<int, std::list<int>> move(othelloBoard &board,
                 std::unordered_map<int, std::list<int>> &legalMoves,
                 bool &pass, std::string &moveHistory);
 
+        // Set from any thread to abort the running search. The search
+        // returns the result of the last completed iteration.
+        std::atomic<bool> stop{false};
+
+        // Searches board for this player without console output or opening
+        // book, using iterative deepening within the given limits. progress
+        // is called after every completed iteration.
+        searchResult analyze(othelloBoard &board, const searchLimits &limits,
+                std::function<void(const searchResult &)> progress = nullptr);
+
+        // Selects the evaluation function used by the search
+        void setEvaluator(evaluatorType type);
+
+        // Seeds the generator that breaks ties between equal moves. Every
+        // player has its own, so searches on different threads neither
+        // share nor contend for random state.
+        void seed(unsigned value);
+
     private:
         struct node {
             bool isMaxNode;
@@ -30,14 +129,40 @@ class othelloPlayer {
             std::unordered_map<int, std::list<int>>::iterator prevIterator;
             std::unordered_map<int, std::list<int>>::iterator moveIterator;
             std::unordered_map<int, std::list<int>>::iterator lastMove;
+            std::array<int, boardSquares> pv;
+            int pvLength;
+            // Table key, 0 if the node is not stored; and the window the
+            // node was entered with, to tell bounds from exact scores
+            uint64_t key;
+            int alphaEntry;
+            int betaEntry;
+            // Endgame cache key, 0 if the node is not stored, and the
+            // symmetry that goes with it
+            uint64_t endgameKey;
+            int endgameSymmetry;
         };
 
-        std::array<node, 64> nodeStack = {};
+        std::array<node, boardSquares> nodeStack = {};
+        // Position of the current iteration in the node stack, kept between
+        // calls to continueIteration
+        int stackDepth = 0;
+        int depthLimit = 0;
+        std::unordered_map<int, std::list<int>>::iterator bestMove;
+        long long nodes = 0;
+        // Searches abort once nodes reaches nodeLimit; 0 for no limit
+        long long nodeLimit = 0;
+        // Moved off the score a node takes from the child that prunes it,
+        // away from the parent's window. Plain searches use 1; multi-PV
+        // searches use 0, as the adjustment can leak into the scores of
+        // root moves reported as exact.
+        int pruneAdjustment = 1;
         //std::array<std::array<int, 2>, 64> killerMoves = {};
 
         othelloHeuristic heuristic;
-
-        othelloDatabase database;
+        std::minstd_rand random;
+        // Tree of the Monte-Carlo search, kept from move to move; created
+        // on first use
+        std::unique_ptr<othelloMCTS> mcts;
 
         // Prompts user for next move
         std::pair<int, std::list<int>> humanMove(
@@ -49,6 +174,60 @@ class othelloPlayer {
         std::pair<int, std::list<int>> computerMove(othelloBoard &board,
                 std::unordered_map<int, std::list<int>> &legalMoves, bool &pass, std::string &moveHistory);
 
+        // Table for multi-PV searches when table is not set
+        std::unique_ptr<othelloTable> ownTable;
+
+        // Helper searchers for root splitting, and the player they work for
+        std::vector<std::unique_ptr<othelloPlayer>> helpers;
+        othelloPlayer *master = nullptr;
+        // Allocations made on a helper's thread during the current analyze
+        allocCounters allocations;
+
+        // One iteration of iterative deepening, single-threaded or split
+        // over the helpers. Return false if the iteration was aborted.
+        bool searchIteration(othelloBoard &board, int depthLimit,
+                std::chrono::time_point<std::chrono::system_clock> startTime,
+                float timeLimit, searchResult &result);
+        bool parallelIteration(othelloBoard &board, int workers,
+                int depthLimit,
+                std::chrono::time_point<std::chrono::system_clock> startTime,
+                float timeLimit, searchResult &result);
+        bool multiPVIteration(othelloBoard &board, int count, int depthLimit,
+                std::chrono::time_point<std::chrono::system_clock> startTime,
+                float timeLimit, searchResult &result);
+        long long totalNodes(int workers);
+
+        // Copies the child's principal variation behind the move just
+        // searched at depth
+        void updatePV(int depth, bool leaf);
+
+        // Looks up the node just pushed at depth; on a usable entry the node
+        // takes its score and has no moves left to search
+        void probeTable(int depth);
+        // Stores the score of the node about to be popped at depth
+        void storeTable(int depth);
+        // Whether an entry's bound settles the score of the node at depth
+        bool usableEntry(const tableEntry &entry, int depth) const;
+
+        // The endgame cache side of probeTable and storeTable, for nodes
+        // searched to the end of the game. Cached scores are converted
+        // from final disc differences of the side to move.
+        bool probeEndgameCache(int depth, int toMove);
+        void storeEndgameCache(int depth, int toMove);
+        // Looks up the root, taking its move and score from the cache, or
+        // stores the result of a completed search to the end of the game
+        bool rootSolved(const othelloBoard &board, searchResult &result);
+        void storeRoot(const othelloBoard &board, const searchResult &result);
+
+        // Generates (and filters) the root moves, sets result.move to a
+        // legal fallback and returns the maximum depth, 0 if there are no
+        // moves
+        int prepareRoot(othelloBoard &board, const searchLimits &limits,
+                searchResult &result);
+
+        // Copies the completed iteration's move, score and PV into result
+        void collectResult(searchResult &result);
+
         // Returns time point
         std::chrono::time_point<std::chrono::system_clock> startTimer();
 
@@ -63,6 +242,27 @@ class othelloPlayer {
                 othelloBoard &theBoard, int depthLimit,
                 std::chrono::time_point<std::chrono::system_clock> startTime,
                 float timeLimit);
+
+        // depthLimitedAlphaBeta in slices: beginIteration sets up the node
+        // stack, and continueIteration runs it for at most budget nodes
+        // (0 for no limit), leaving the stack ready for the next call. A
+        // root alpha above INT_MIN only proves root scores up to alpha.
+        enum class iterationStatus {complete, paused, aborted};
+        void beginIteration(othelloBoard &board, int depthLimit,
+                int alpha = INT_MIN);
+        iterationStatus continueIteration(long long budget,
+                std::chrono::time_point<std::chrono::system_clock> startTime,
+                float timeLimit);
+        template <int searcher>
+        iterationStatus continueIterationAs(long long budget,
+                std::chrono::time_point<std::chrono::system_clock> startTime,
+                float timeLimit);
+        // The step of continueIterationAs that makes a move of mover, the
+        // side to move at depth, specialised on it
+        template <int searcher, int mover>
+        void searchNextMove(int &depth, int depthLimit);
+
+        friend class othelloSearch;
 };
 
 #endif //PLAYER_HPP
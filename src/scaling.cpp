@@ -0,0 +1,189 @@
+// Thread-scaling benchmark for the parallel search.
+//
+// Usage: scaling.exe [--depth N] [--time S] [--max-threads N] [--json FILE]
+//                    [FILE...]
+//
+// Searches a fixed set of positions (test/scaling.txt by default) with
+// analyze, as computerMove does, at 1, 2, 4 ... threads up to --max-threads
+// (the number of cores by default). Every position is searched once to a
+// fixed depth (default 6) and once for a fixed time per move (default 1s).
+// Relative to one thread, the fixed-depth runs give the time-to-depth
+// speedup and the node-count overhead, and both runs give the NPS scaling.
+
+#include <iomanip>
+#include "analysis.hpp"
+
+struct scalingRun {
+    int threads = 1;
+    // Fixed-depth runs: total time and nodes
+    float depthTime = 0;
+    long long depthNodes = 0;
+    // Fixed-time runs: total time, nodes and completed depth
+    float timeTime = 0;
+    long long timeNodes = 0;
+    int timeDepth = 0;
+};
+
+// Searches every position with the given limits and thread count, adding
+// up time, nodes and completed depth
+void searchAll(const std::vector<analysisTask> &tasks,
+        const searchLimits &limits, int threads, float &time,
+        long long &nodes, int &depth) {
+    for (const analysisTask &task : tasks) {
+        othelloPlayer player;
+        player.computer = true;
+        player.threads = threads;
+        player.color = task.toMove;
+
+        othelloBoard board = task.board;
+        searchResult result = player.analyze(board, limits);
+        time += result.time;
+        nodes += result.nodes;
+        depth += result.depth;
+    }
+}
+
+double nps(long long nodes, float time) {
+    return nodes / std::max(time, 1e-6f);
+}
+
+void writeJson(std::ostream &os, const std::vector<scalingRun> &runs,
+        int depth, float time, size_t positions) {
+    const scalingRun &base = runs.front();
+    os << "{" << std::endl;
+    os << "  \"positions\": " << positions << "," << std::endl;
+    os << "  \"depth\": " << depth << "," << std::endl;
+    os << "  \"time\": " << time << "," << std::endl;
+    os << "  \"runs\": [" << std::endl;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const scalingRun &run = runs[i];
+        os << "    {\"threads\": " << run.threads
+            << ", \"depthTime\": " << run.depthTime
+            << ", \"depthNodes\": " << run.depthNodes
+            << ", \"speedup\": " << base.depthTime / run.depthTime
+            << ", \"nodeOverhead\": "
+            << (double) run.depthNodes / base.depthNodes - 1
+            << ", \"depthNps\": " << (long long) nps(run.depthNodes, run.depthTime)
+            << ", \"timeNodes\": " << run.timeNodes
+            << ", \"timeNps\": " << (long long) nps(run.timeNodes, run.timeTime)
+            << ", \"npsScaling\": " << nps(run.timeNodes, run.timeTime)
+                / nps(base.timeNodes, base.timeTime)
+            << ", \"averageDepth\": " << (double) run.timeDepth / positions
+            << "}" << (i + 1 < runs.size() ? "," : "") << std::endl;
+    }
+    os << "  ]" << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    searchLimits depthLimits, timeLimits;
+    depthLimits.depth = 6;
+    timeLimits.time = 1.0;
+    int maxThreads = std::thread::hardware_concurrency();
+    std::string jsonFile;
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) {
+                inputs.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--depth") {
+                depthLimits.depth = std::stoi(value);
+            }
+            else if (arg == "--time") {
+                timeLimits.time = std::stof(value);
+            }
+            else if (arg == "--max-threads") {
+                maxThreads = std::stoi(value);
+            }
+            else if (arg == "--json") {
+                jsonFile = value;
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+    if (inputs.empty()) {
+        inputs.push_back("../test/scaling.txt");
+    }
+
+    std::vector<analysisTask> tasks;
+    std::string error;
+    for (const std::string &input : inputs) {
+        if (!readPositions(input, searchLimits(), tasks, error)) {
+            std::cout << error << std::endl;
+            return 1;
+        }
+    }
+    if (tasks.empty()) {
+        std::cout << "No positions!" << std::endl;
+        return 1;
+    }
+
+    // 1, 2, 4 ... threads, and the maximum itself
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(std::max(maxThreads, 1));
+
+    std::cout << tasks.size() << " positions, depth " << depthLimits.depth
+        << ", " << timeLimits.time << "s per position" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(11) << "time"
+        << std::setw(9) << "speedup" << std::setw(13) << "nodes"
+        << std::setw(10) << "overhead" << std::setw(11) << "nps"
+        << std::setw(11) << "timed nps" << std::setw(9) << "scaling"
+        << std::setw(7) << "depth" << std::endl;
+
+    std::vector<scalingRun> runs;
+    for (int threads : threadCounts) {
+        scalingRun run;
+        run.threads = threads;
+        int depth = 0;
+        searchAll(tasks, depthLimits, threads, run.depthTime, run.depthNodes,
+                depth);
+        searchAll(tasks, timeLimits, threads, run.timeTime, run.timeNodes,
+                run.timeDepth);
+        runs.push_back(run);
+
+        const scalingRun &base = runs.front();
+        std::cout << std::fixed << std::setprecision(2)
+            << std::setw(8) << threads
+            << std::setw(10) << run.depthTime << "s"
+            << std::setw(9) << base.depthTime / run.depthTime
+            << std::setw(13) << run.depthNodes
+            << std::setw(9)
+            << 100*((double) run.depthNodes / base.depthNodes - 1) << "%"
+            << std::setw(11) << (long long) nps(run.depthNodes, run.depthTime)
+            << std::setw(11) << (long long) nps(run.timeNodes, run.timeTime)
+            << std::setw(9) << nps(run.timeNodes, run.timeTime)
+                / nps(base.timeNodes, base.timeTime)
+            << std::setw(7) << (double) run.timeDepth / tasks.size()
+            << std::endl;
+    }
+
+    if (!jsonFile.empty()) {
+        std::ofstream ofs(jsonFile.c_str());
+        if (!ofs.good()) {
+            std::cout << "Could not write " << jsonFile << std::endl;
+            return 1;
+        }
+        writeJson(ofs, runs, depthLimits.depth, timeLimits.time, tasks.size());
+    }
+
+    return 0;
+}
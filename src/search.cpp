@@ -0,0 +1,95 @@
+#include "search.hpp"
+
+othelloSearch::othelloSearch(const othelloBoard &board, int color,
+        const searchLimits &limits, evaluatorType evaluator,
+        othelloTable *table)
+    : root(board), limits(limits) {
+    this->player.computer = true;
+    this->player.color = color;
+    this->player.setEvaluator(evaluator);
+    this->player.nodeLimit = limits.nodes;
+    this->player.table = table;
+
+    this->maxDepth = this->player.prepareRoot(this->root, limits,
+            this->current);
+    this->finished = (this->maxDepth == 0);
+}
+
+/**
+ * @brief 继续搜索至多 budget 个节点
+ *
+ * 迭代加深：当前迭代完成后开始下一层，直到达到最大深度、时间或节点限制。
+ * 时间只计算在 step 内花费的时间，因此暂停期间不消耗时间限制。
+ *
+ * @param budget 本次最多搜索的节点数
+ * @return 搜索已结束时返回 true
+ */
+bool othelloSearch::step(long long budget) {
+    if (this->finished) {
+        return true;
+    }
+
+    // Shift the start time so the limit only counts time spent in slices
+    std::chrono::time_point<std::chrono::system_clock> sliceStart =
+        std::chrono::system_clock::now();
+    std::chrono::time_point<std::chrono::system_clock> startTime = sliceStart
+        - std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                this->elapsed);
+    float timeLimit = (this->limits.time > 0)
+        ? this->limits.time : std::numeric_limits<float>::max();
+
+    allocCounters startAllocations = threadAllocCounters();
+    long long remaining = std::max(budget, 1LL);
+    while (remaining > 0 && !this->finished) {
+        if (!this->iterating) {
+            if (this->depthLimit == this->maxDepth) {
+                this->finished = true;
+                break;
+            }
+            this->player.beginIteration(this->root, ++this->depthLimit);
+            this->iterating = true;
+        }
+
+        long long before = this->player.nodes;
+        othelloPlayer::iterationStatus status = this->player.continueIteration(
+                remaining, startTime, timeLimit);
+        remaining -= this->player.nodes - before;
+
+        if (status == othelloPlayer::iterationStatus::complete) {
+            this->iterating = false;
+            this->player.collectResult(this->current);
+            this->current.depth = this->depthLimit;
+
+            std::chrono::duration<float> used =
+                std::chrono::system_clock::now() - startTime;
+            if (this->limits.time > 0 && used.count() > 0.5*this->limits.time) {
+                this->finished = true;
+            }
+        }
+        else if (status == othelloPlayer::iterationStatus::aborted) {
+            this->finished = true;
+        }
+        else {
+            break;
+        }
+    }
+
+    this->elapsed += std::chrono::system_clock::now() - sliceStart;
+    this->current.allocations += threadAllocCounters() - startAllocations;
+    this->current.nodes = this->player.nodes;
+    this->current.time = this->elapsed.count();
+    return this->finished;
+}
+
+bool othelloSearch::done() const {
+    return this->finished;
+}
+
+const searchResult &othelloSearch::result() const {
+    return this->current;
+}
+
+void othelloSearch::stop() {
+    this->finished = true;
+    this->iterating = false;
+}
@@ -0,0 +1,45 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include "player.hpp"
+
+// A resumable search, run in slices of a given number of nodes so that one
+// thread can interleave the searches of many games. All search state lives
+// in the object between slices. It searches like othelloPlayer::analyze on
+// one thread: iterative deepening within limits, where the time limit
+// counts only the time spent inside step. Unlike analyze, it does not age
+// the table; that is up to whoever shares the table between searches.
+class othelloSearch {
+    public:
+        othelloSearch(const othelloBoard &board, int color,
+                const searchLimits &limits,
+                evaluatorType evaluator = evaluatorType::standard,
+                othelloTable *table = nullptr);
+
+        // Searches at most budget nodes (any positive number). Returns true
+        // once the search is finished.
+        bool step(long long budget);
+
+        bool done() const;
+
+        // The last completed iteration, or the first legal move before any
+        // iteration completes; move is -1 if there are no legal moves
+        const searchResult &result() const;
+
+        // Finishes the search, keeping the last completed iteration
+        void stop();
+
+    private:
+        othelloPlayer player;
+        othelloBoard root;
+        searchLimits limits;
+        searchResult current;
+        int maxDepth = 0;
+        int depthLimit = 0;
+        bool iterating = false;
+        bool finished = false;
+        // Time spent inside step
+        std::chrono::duration<float> elapsed{0};
+};
+
+#endif // SEARCH_HPP
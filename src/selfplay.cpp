@@ -0,0 +1,330 @@
+// Parallel self-play generator for labelled training positions.
+//
+// Usage: selfplay.exe [--games N] [--threads N] [--seed N]
+//                     [--random-plies N] [--temperature T]
+//                     [--temperature-plies N] [--depth N] [--sample P]
+//                     [--label-depth N] [--exact-empties N] [--hash MB]
+//                     [--output FILE] [--corpus FILE]
+//                     [--endgame-cache FILE]
+//
+// Plays randomised self-play games on all cores. The first --random-plies
+// moves of a game are uniformly random; for the next --temperature-plies
+// moves every legal move is scored by a multi-PV search of --depth plies
+// and one is drawn with probability proportional to exp(score / T), with T
+// in evaluation units; after that the best move is played. Every position
+// after the random opening is sampled with probability --sample, dropped if
+// an equal position (same discs and side to move) was sampled before, and
+// labelled: by an exact solve with at most --exact-empties empty squares
+// or at most --label-depth (the final disc difference), and by a
+// --label-depth search otherwise (in evaluation units). Scores are from the side to move.
+//
+// Positions are streamed in game order to --output (stdout unless only
+// --corpus is given) in the one-line format of --analyze, as
+// "POSITION SIDE ; SCORE exact|dN MOVE" with the best move of the labelling
+// search, and to a binary position corpus (--corpus, see corpus.hpp).
+// Every game draws from its own generator seeded by --seed and the game
+// number, so with one thread the output only depends on the options.
+// With --endgame-cache, exact labels are looked up in and added to a
+// persistent endgame cache (see endgame.hpp), shared by all threads and by
+// other runs.
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <unordered_set>
+#include "analysis.hpp"
+#include "corpus.hpp"
+#include "threadpool.hpp"
+
+struct selfplayOptions {
+    int games = 1000;
+    unsigned seed = 1;
+    int randomPlies = 8;
+    double temperature = 200;
+    int temperaturePlies = 20;
+    int depth = 4;
+    double sample = 0.25;
+    int labelDepth = 8;
+    int exactEmpties = 10;
+    size_t hashBytes = 16 << 20;
+};
+
+// Searchers and table owned by one worker thread
+struct selfplayWorker {
+    othelloPlayer mover;
+    othelloPlayer labeller;
+    std::unique_ptr<othelloTable> table;
+};
+
+// Labelled positions of one game
+struct selfplayGame {
+    std::vector<corpusRecord> positions;
+};
+
+// Shared record of the positions sampled so far
+struct sampledPositions {
+    std::unordered_set<uint64_t> keys;
+    std::mutex mutex;
+
+    // Returns true the first time a position is seen
+    bool insert(uint64_t key) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->keys.insert(key).second;
+    }
+};
+
+/**
+ * @brief 按温度从多主要变例结果中抽取走法
+ *
+ * @param lines 所有根走法及其分数
+ * @param temperature 温度（评估单位）
+ * @param rng 随机数生成器
+ * @return 抽中的走法
+ */
+int sampleMove(const std::vector<searchLine> &lines, double temperature,
+        std::mt19937 &rng) {
+    std::vector<double> weights;
+    for (const searchLine &line : lines) {
+        weights.push_back(std::exp((line.score - lines[0].score) / temperature));
+    }
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+    return lines[pick(rng)].move;
+}
+
+/**
+ * @brief 下一盘自对弈并生成带标签的局面
+ *
+ * @param index 对局编号，与 --seed 一起决定随机数
+ * @param options 生成选项
+ * @param worker 当前线程的搜索器
+ * @param sampled 已采样局面，用于去重
+ * @param game 写入本局的输出
+ */
+void playGame(int index, const selfplayOptions &options,
+        selfplayWorker &worker, sampledPositions &sampled,
+        selfplayGame &game) {
+    std::seed_seq sequence{options.seed, (unsigned) index};
+    std::mt19937 rng(sequence);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    worker.mover.seed(rng());
+    worker.labeller.seed(rng());
+
+    othelloBoard board;
+    board.startPosition();
+    int toMove = 1;
+    bool passed = false;
+
+    for (int ply = 0; ; ply++) {
+        board.findLegalMoves(toMove, &board.moves);
+        if (board.moves.empty()) {
+            if (passed) {
+                break;
+            }
+            passed = true;
+            toMove = -toMove;
+            continue;
+        }
+        passed = false;
+
+        // Sample and label the position
+        if (ply >= options.randomPlies && uniform(rng) < options.sample
+                && sampled.insert(othelloTable::hash(board, toMove, 1,
+                        evaluatorType::standard))) {
+            // A label search that reaches the end of the game is a solve
+            int empties = boardSquares - board.discsOnBoard;
+            bool exact = (empties <= options.exactEmpties
+                    || options.labelDepth >= empties);
+            searchLimits limits;
+            limits.depth = exact ? empties : options.labelDepth;
+            othelloBoard root = board;
+            worker.labeller.color = toMove;
+            searchResult label = worker.labeller.analyze(root, limits);
+
+            corpusRecord record = corpusRecord::fromBoard(board, toMove);
+            record.score = exact
+                ? othelloHeuristic::discScore(label.score) : label.score;
+            record.flags = hasScore | hasMove | (exact ? exactScore : 0);
+            record.depth = exact ? 0 : label.depth;
+            record.move = label.move;
+            game.positions.push_back(record);
+        }
+
+        int square;
+        if (ply < options.randomPlies) {
+            auto it = board.moves.begin();
+            std::advance(it, std::uniform_int_distribution<int>(0,
+                        board.moves.size() - 1)(rng));
+            square = it->first;
+        }
+        else {
+            bool explore = (ply < options.randomPlies + options.temperaturePlies
+                    && options.temperature > 0);
+            searchLimits limits;
+            limits.depth = options.depth;
+            limits.multiPV = explore ? 0 : 1;
+            othelloBoard root = board;
+            worker.mover.color = toMove;
+            searchResult result = worker.mover.analyze(root, limits);
+            square = explore && !result.lines.empty()
+                ? sampleMove(result.lines, options.temperature, rng)
+                : result.move;
+        }
+
+        board.updateBoard(toMove, *board.moves.find(square));
+        board.discsOnBoard++;
+        toMove = -toMove;
+    }
+}
+
+int main(int argc, char **argv) {
+    selfplayOptions options;
+    int numThreads = std::thread::hardware_concurrency();
+    std::string outputFile, corpusFile, cacheFile;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--games") {
+                options.games = std::stoi(value);
+            }
+            else if (arg == "--threads") {
+                numThreads = std::stoi(value);
+            }
+            else if (arg == "--seed") {
+                options.seed = std::stoul(value);
+            }
+            else if (arg == "--random-plies") {
+                options.randomPlies = std::stoi(value);
+            }
+            else if (arg == "--temperature") {
+                options.temperature = std::stod(value);
+            }
+            else if (arg == "--temperature-plies") {
+                options.temperaturePlies = std::stoi(value);
+            }
+            else if (arg == "--depth") {
+                options.depth = std::stoi(value);
+            }
+            else if (arg == "--sample") {
+                options.sample = std::stod(value);
+            }
+            else if (arg == "--label-depth") {
+                options.labelDepth = std::stoi(value);
+            }
+            else if (arg == "--exact-empties") {
+                options.exactEmpties = std::stoi(value);
+            }
+            else if (arg == "--hash") {
+                options.hashBytes = std::stoul(value) << 20;
+            }
+            else if (arg == "--output") {
+                outputFile = value;
+            }
+            else if (arg == "--corpus") {
+                corpusFile = value;
+            }
+            else if (arg == "--endgame-cache") {
+                cacheFile = value;
+            }
+            else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cerr << "Invalid option value" << std::endl;
+        return 1;
+    }
+    numThreads = std::max(numThreads, 1);
+
+    std::ofstream ofs;
+    if (!outputFile.empty()) {
+        ofs.open(outputFile.c_str());
+        if (!ofs.good()) {
+            std::cerr << "Could not write " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &os = outputFile.empty() ? std::cout : ofs;
+    bool text = !outputFile.empty() || corpusFile.empty();
+    othelloCorpusWriter corpus;
+    if (!corpusFile.empty() && !corpus.open(corpusFile)) {
+        std::cerr << "Could not write " << corpusFile << std::endl;
+        return 1;
+    }
+    othelloEndgameCache cache;
+    if (!cacheFile.empty() && !cache.open(cacheFile)) {
+        std::cerr << cache.error() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<selfplayWorker>> workers;
+    for (int i = 0; i < numThreads; i++) {
+        workers.emplace_back(new selfplayWorker());
+        selfplayWorker &worker = *workers.back();
+        worker.table.reset(new othelloTable(options.hashBytes));
+        worker.mover.computer = true;
+        worker.labeller.computer = true;
+        worker.labeller.table = worker.table.get();
+        worker.labeller.endgameCache = cache.isOpen() ? &cache : nullptr;
+    }
+
+    // Games are written in order as soon as all earlier games are done
+    sampledPositions sampled;
+    std::vector<selfplayGame> games(options.games);
+    std::vector<bool> done(options.games, false);
+    int next = 0;
+    long long positions = 0;
+    bool failed = false;
+    std::mutex mutex;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        othelloThreadPool pool(numThreads);
+        for (int i = 0; i < options.games; i++) {
+            pool.submit([&, i](int worker) {
+                playGame(i, options, *workers[worker], sampled, games[i]);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = true;
+                for (; next < options.games && done[next]; next++) {
+                    for (const corpusRecord &record : games[next].positions) {
+                        if (text) {
+                            os << corpusLine(record) << '\n';
+                        }
+                        if (!corpusFile.empty() && !corpus.add(record)) {
+                            failed = true;
+                        }
+                    }
+                    positions += games[next].positions.size();
+                    games[next] = selfplayGame();
+                }
+                os.flush();
+            });
+        }
+        pool.wait();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (!corpusFile.empty() && (!corpus.close() || failed)) {
+        std::cerr << "Could not write " << corpusFile << std::endl;
+        return 1;
+    }
+    if (!outputFile.empty() && !ofs.good()) {
+        std::cerr << "Could not write " << outputFile << std::endl;
+        return 1;
+    }
+
+    std::cerr << options.games << " games, " << positions << " positions, "
+        << elapsed.count() << "s ("
+        << (long long) (positions / std::max(elapsed.count(), 1e-6))
+        << " positions/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,557 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <new>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+#include "table.hpp"
+
+namespace {
+    // splitmix64, for reproducible Zobrist keys
+    uint64_t nextKey(uint64_t &state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    struct zobristKeys {
+        uint64_t squares[boardSquares][2];
+        uint64_t whiteToMove;
+        uint64_t whiteSearching;
+        uint64_t evaluators[3];
+
+        static const uint64_t seed = 0x6f74746f;
+
+        zobristKeys() {
+            uint64_t state = seed;
+            for (auto &square : this->squares) {
+                square[0] = nextKey(state);
+                square[1] = nextKey(state);
+            }
+            this->whiteToMove = nextKey(state);
+            this->whiteSearching = nextKey(state);
+            for (uint64_t &evaluator : this->evaluators) {
+                evaluator = nextKey(state);
+            }
+        }
+    };
+
+    const zobristKeys &keys() {
+        static const zobristKeys keys;
+        return keys;
+    }
+
+    // Huge page size on x86-64, and the alignment transparent huge pages
+    // need
+    const size_t hugePageSize = 2 << 20;
+
+    // Bits per word of a node mask
+    const int maskBits = 8*sizeof(unsigned long);
+
+    // Reads the online memory nodes, a list of ranges such as "0-3,6",
+    // into a node mask; returns the highest node, or -1 on failure
+    int onlineNodes(std::vector<unsigned long> &mask) {
+        std::ifstream ifs("/sys/devices/system/node/online");
+        std::string list;
+        if (!std::getline(ifs, list)) {
+            return -1;
+        }
+
+        int highest = -1;
+        std::istringstream iss(list);
+        std::string range;
+        while (std::getline(iss, range, ',')) {
+            int first = 0, last = 0;
+            char dash = 0;
+            std::istringstream rss(range);
+            if (!(rss >> first) || first < 0) {
+                return -1;
+            }
+            last = (rss >> dash >> last && dash == '-') ? last : first;
+            for (int node = first; node <= last; node++) {
+                if (node / maskBits >= (int) mask.size()) {
+                    mask.resize(node / maskBits + 1, 0);
+                }
+                mask[node / maskBits] |= 1UL << (node % maskBits);
+            }
+            highest = std::max(highest, last);
+        }
+        return highest;
+    }
+
+    // Asks for transparent huge pages and NUMA interleaving on a mapping
+    // whose pages have not been touched yet. Huge pages are a hint; if
+    // interleaving was asked for but fails, the pages stay first-touch and
+    // error says why.
+    void placePages(void *addr, size_t bytes, const tableMemory &memory,
+            std::string &error) {
+#ifdef MADV_HUGEPAGE
+        if (memory.hugePages && bytes >= hugePageSize) {
+            madvise(addr, bytes, MADV_HUGEPAGE);
+        }
+#endif
+        if (!memory.interleave) {
+            return;
+        }
+#if defined(__linux__) && defined(SYS_mbind)
+        std::vector<unsigned long> nodes;
+        int highest = onlineNodes(nodes);
+        if (highest < 0) {
+            error = "NUMA interleaving: cannot read the online memory nodes";
+        }
+        // The kernel reads maxnode - 1 bits of the mask
+        else if (syscall(SYS_mbind, addr, bytes, MPOL_INTERLEAVE,
+                    nodes.data(), (unsigned long) highest + 2, 0) != 0) {
+            error = std::string("NUMA interleaving: ") + std::strerror(errno);
+        }
+#else
+        (void) addr;
+        (void) bytes;
+        error = "NUMA interleaving is not supported on this system";
+#endif
+    }
+}
+
+// Maps the slots privately, on huge pages if possible
+/**
+ * @brief 分配置换表
+ *
+ * 使用匿名映射而非 new：内存在首次访问时才分配并清零。页面按内核的默认策略
+ * 落在首先访问它的线程所在的 NUMA 节点上（搜索线程并不绑定节点），或按要求
+ * 交错分布在所有在线节点上。请求大页时先尝试
+ * 系统预留的显式大页，失败则对按大页对齐的普通映射申请透明大页。
+ *
+ * @param bytes 置换表的大小上限
+ * @param memory 大页与 NUMA 放置选项
+ */
+othelloTable::othelloTable(size_t bytes, const tableMemory &memory) {
+    size_t count = 1;
+    while (2*count*sizeof(slot) <= bytes) {
+        count *= 2;
+    }
+    size_t size = count*sizeof(slot);
+
+    void *addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (memory.hugePages && size >= hugePageSize) {
+        this->mappingSize = (size + hugePageSize - 1) & ~(hugePageSize - 1);
+        addr = mmap(nullptr, this->mappingSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (addr != MAP_FAILED) {
+        this->slots = static_cast<slot *>(addr);
+    }
+    else {
+        // Over-allocate so that the slots can start on a huge page boundary
+        size_t align = (memory.hugePages && size >= hugePageSize)
+            ? hugePageSize : 0;
+        this->mappingSize = size + align;
+        addr = mmap(nullptr, this->mappingSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+        if (align > 0) {
+            start = (start + align - 1) & ~(uintptr_t) (align - 1);
+        }
+        this->slots = reinterpret_cast<slot *>(start);
+    }
+
+    this->mapping = addr;
+    this->mask = count - 1;
+    placePages(this->slots, size, memory, this->placementMessage);
+}
+
+othelloTable::~othelloTable() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mappingSize);
+    }
+}
+
+// Maps a named segment, initialising it under an exclusive lock if it is new
+/**
+ * @brief 打开共享内存中的置换表
+ *
+ * 用 shm_open 打开或创建命名段，并在排他锁下检查其大小：新段扩展到固定大小
+ * 并写入文件头（全零的槽即为空），已有的段校验文件头，包括 Zobrist 种子与
+ * 校验键。表项仍以键与数据的异或校验，因此各进程无需加锁即可同时读写。
+ *
+ * @param name 段名，以 '/' 开头
+ * @param bytes 新建段的大小上限
+ * @param error 失败时写入错误信息
+ * @param memory 大页与 NUMA 放置选项，只影响尚未被访问的页面
+ * @return 置换表，失败时返回 nullptr
+ */
+std::unique_ptr<othelloTable> othelloTable::openShared(
+        const std::string &name, size_t bytes, std::string &error,
+        const tableMemory &memory) {
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        error = name + ": could not open shared memory";
+        return nullptr;
+    }
+
+    flock(fd, LOCK_EX);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        uint64_t count = 1;
+        while (2*count*sizeof(slot) <= bytes) {
+            count *= 2;
+        }
+
+        st.st_size = sizeof(sharedTableHeader) + count*sizeof(slot);
+        sharedTableHeader header = {};
+        std::memcpy(header.magic, sharedTableMagic, sizeof(sharedTableMagic));
+        header.version = sharedTableVersion;
+        header.slotSize = sizeof(slot);
+        header.slots = count;
+        header.seed = zobristKeys::seed;
+        header.keyCheck = keys().evaluators[2];
+        if (ftruncate(fd, st.st_size) != 0
+                || pwrite(fd, &header, sizeof(header), 0)
+                    != (ssize_t) sizeof(header)) {
+            shm_unlink(name.c_str());
+            ::close(fd);
+            error = name + ": could not create shared memory";
+            return nullptr;
+        }
+    }
+
+    void *addr = (st.st_size < (off_t) sizeof(sharedTableHeader))
+        ? MAP_FAILED
+        : mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        error = name + ": not a shared table";
+        return nullptr;
+    }
+
+    sharedTableHeader *header = static_cast<sharedTableHeader *>(addr);
+    uint64_t count = header->slots;
+    if (std::memcmp(header->magic, sharedTableMagic,
+                sizeof(sharedTableMagic)) != 0
+            || header->version != sharedTableVersion
+            || header->slotSize != sizeof(slot)
+            || count == 0 || (count & (count - 1)) != 0
+            || sizeof(sharedTableHeader) + count*sizeof(slot)
+                > (uint64_t) st.st_size) {
+        munmap(addr, st.st_size);
+        error = name + ": not a shared table";
+        return nullptr;
+    }
+    if (header->seed != zobristKeys::seed
+            || header->keyCheck != keys().evaluators[2]) {
+        munmap(addr, st.st_size);
+        error = name + ": shared table uses other hash keys";
+        return nullptr;
+    }
+
+    std::unique_ptr<othelloTable> table(new othelloTable());
+    table->mapping = addr;
+    table->mappingSize = st.st_size;
+    table->slots = reinterpret_cast<slot *>(
+            static_cast<char *>(addr) + sizeof(sharedTableHeader));
+    table->mask = count - 1;
+    table->generation = &header->generation;
+    placePages(addr, st.st_size, memory, table->placementMessage);
+    return table;
+}
+
+uint64_t othelloTable::hash(const othelloBoard &board, int toMove, int color,
+        evaluatorType evaluator) {
+    const zobristKeys &k = keys();
+    uint64_t key = k.evaluators[static_cast<int>(evaluator)];
+    for (int i = 0; i < boardSquares; i++) {
+        if (board.positions[i] == 1) {
+            key ^= k.squares[i][0];
+        }
+        else if (board.positions[i] == -1) {
+            key ^= k.squares[i][1];
+        }
+    }
+    if (toMove == -1) {
+        key ^= k.whiteToMove;
+    }
+    if (color == -1) {
+        key ^= k.whiteSearching;
+    }
+    return key;
+}
+
+// Hashes every symmetric image of the board in one pass and keeps the
+// smallest key
+/**
+ * @brief 计算与对称无关的局面键
+ *
+ * 对棋盘的八种对称变换同时计算 Zobrist 键，取最小者，因此对称的局面得到相同
+ * 的键。键与搜索方和估值函数无关。
+ *
+ * @param board 棋盘
+ * @param toMove 轮到走棋的一方
+ * @param symmetry 写入取得最小键的对称变换
+ * @return 局面键
+ */
+uint64_t othelloTable::canonicalHash(const othelloBoard &board, int toMove,
+        int &symmetry) {
+    const zobristKeys &k = keys();
+    uint64_t images[8] = {};
+    for (int i = 0; i < boardSquares; i++) {
+        if (board.positions[i] == 0) {
+            continue;
+        }
+        int disc = (board.positions[i] == 1) ? 0 : 1;
+        for (int s = 0; s < 8; s++) {
+            images[s] ^= k.squares[symmetricSquare(i, s)][disc];
+        }
+    }
+
+    symmetry = 0;
+    for (int s = 1; s < 8; s++) {
+        if (images[s] < images[symmetry]) {
+            symmetry = s;
+        }
+    }
+    return images[symmetry] ^ (toMove == -1 ? k.whiteToMove : 0);
+}
+
+uint64_t othelloTable::keySeed() {
+    return zobristKeys::seed;
+}
+
+uint64_t othelloTable::keyCheck() {
+    return keys().evaluators[2];
+}
+
+int othelloTable::symmetricSquare(int square, int symmetry) {
+    int row = geometry::row(square), col = geometry::col(square);
+    if (symmetry & 1) {
+        row = boardSide - 1 - row;
+    }
+    if (symmetry & 2) {
+        col = boardSide - 1 - col;
+    }
+    return (symmetry & 4) ? geometry::square(col, row)
+        : geometry::square(row, col);
+}
+
+// Mirroring the rows and then transposing is the same as transposing and
+// then mirroring the columns, so the inverse of a transposing symmetry
+// swaps its two mirror bits
+int othelloTable::inverseSymmetry(int symmetry) {
+    return (symmetry & 4)
+        ? 4 | (symmetry & 1) << 1 | (symmetry & 2) >> 1 : symmetry;
+}
+
+// Layout: score (32 bits), depth (8), bound (2), move + 1 (7), generation (8)
+uint64_t othelloTable::pack(const tableEntry &entry, uint8_t generation) {
+    return (uint64_t) (uint32_t) entry.score
+        | (uint64_t) (entry.depth & 0xff) << 32
+        | (uint64_t) entry.bound << 40
+        | (uint64_t) (entry.move + 1) << 42
+        | (uint64_t) generation << 49;
+}
+
+void othelloTable::unpack(uint64_t data, tableEntry &entry) {
+    entry.score = (int32_t) (uint32_t) data;
+    entry.depth = (data >> 32) & 0xff;
+    entry.bound = static_cast<boundType>((data >> 40) & 0x3);
+    entry.move = (int) ((data >> 42) & 0x7f) - 1;
+}
+
+uint8_t othelloTable::generationOf(uint64_t data) {
+    return (data >> 49) & 0xff;
+}
+
+bool othelloTable::probe(uint64_t key, tableEntry &entry) const {
+    const slot &s = this->slots[key & this->mask];
+    uint64_t data = s.data.load(std::memory_order_relaxed);
+    uint64_t check = s.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || data == 0) {
+        return false;
+    }
+
+    unpack(data, entry);
+    return entry.bound != boundType::none;
+}
+
+void othelloTable::store(uint64_t key, const tableEntry &entry) {
+    slot &s = this->slots[key & this->mask];
+    uint8_t generation = this->generation->load(std::memory_order_relaxed);
+    uint64_t old = s.data.load(std::memory_order_relaxed);
+    bool samePosition = (s.check.load(std::memory_order_relaxed) ^ old) == key;
+
+    tableEntry current;
+    unpack(old, current);
+    if (old != 0 && !samePosition && generationOf(old) == generation
+            && current.depth > entry.depth) {
+        return;
+    }
+
+    uint64_t data = pack(entry, generation);
+    s.check.store(key ^ data, std::memory_order_relaxed);
+    s.data.store(data, std::memory_order_relaxed);
+}
+
+void othelloTable::newSearch() {
+    this->generation->fetch_add(1, std::memory_order_relaxed);
+}
+
+void othelloTable::clear() {
+    for (size_t i = 0; i <= this->mask; i++) {
+        this->slots[i].check.store(0, std::memory_order_relaxed);
+        this->slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Snapshots are written in blocks of slots
+/**
+ * @brief 将置换表写入文件
+ *
+ * 先写文件头（格式版本、槽大小与数量、Zobrist 种子、校验键与当前代数），
+ * 再按槽顺序写入 (check, data) 对。写入期间不能有搜索在存储。
+ *
+ * @param fileName 快照文件
+ * @param error 失败时写入错误信息
+ * @return 写入成功时返回 true
+ */
+bool othelloTable::save(const std::string &fileName,
+        std::string &error) const {
+    std::ofstream ofs(fileName.c_str(), std::ios::binary);
+    if (!ofs.good()) {
+        error = "Could not write " + fileName;
+        return false;
+    }
+
+    tableFileHeader header = {};
+    std::memcpy(header.magic, tableFileMagic, sizeof(tableFileMagic));
+    header.version = tableFileVersion;
+    header.slotSize = sizeof(slot);
+    header.slots = this->size();
+    header.seed = zobristKeys::seed;
+    header.keyCheck = keys().evaluators[2];
+    header.generation = this->generation->load(std::memory_order_relaxed);
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<uint64_t> block;
+    for (size_t i = 0; i < this->size(); i += 1 << 16) {
+        block.clear();
+        for (size_t j = i; j < this->size() && j < i + (1 << 16); j++) {
+            block.push_back(this->slots[j].check.load(std::memory_order_relaxed));
+            block.push_back(this->slots[j].data.load(std::memory_order_relaxed));
+        }
+        ofs.write(reinterpret_cast<const char *>(block.data()),
+                block.size()*sizeof(uint64_t));
+    }
+
+    if (!ofs.good()) {
+        error = "Could not write " + fileName;
+        return false;
+    }
+    return true;
+}
+
+// Maps a snapshot and copies or rehashes its slots
+/**
+ * @brief 从快照文件载入置换表
+ *
+ * 映射文件并校验文件头：格式版本、槽大小、Zobrist 种子与校验键必须与本程序
+ * 一致，否则表项的键没有意义。大小相同时逐槽复制并恢复代数；大小不同时按
+ * 键重新插入，同一槽保留较深的表项。共享内存中的表不清空也不覆盖，
+ * 快照中的表项按键合并进去，以免抹掉其他进程正在使用的表项。
+ *
+ * @param fileName 快照文件
+ * @param error 失败时写入错误信息
+ * @return 载入成功时返回 true
+ */
+bool othelloTable::load(const std::string &fileName, std::string &error) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = fileName + ": file does not exist";
+        return false;
+    }
+
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(tableFileHeader)) {
+        addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        error = fileName + ": not a table snapshot";
+        return false;
+    }
+
+    const tableFileHeader *header = static_cast<const tableFileHeader *>(addr);
+    if (std::memcmp(header->magic, tableFileMagic, sizeof(tableFileMagic)) != 0
+            || header->version != tableFileVersion
+            || header->slotSize != sizeof(slot)
+            || sizeof(tableFileHeader) + header->slots*sizeof(slot)
+                != (uint64_t) st.st_size) {
+        munmap(addr, st.st_size);
+        error = fileName + ": not a table snapshot";
+        return false;
+    }
+    if (header->seed != zobristKeys::seed
+            || header->keyCheck != keys().evaluators[2]) {
+        munmap(addr, st.st_size);
+        error = fileName + ": table snapshot uses other hash keys";
+        return false;
+    }
+
+    // Other processes search on the entries of a shared table: merge the
+    // snapshot into them instead of replacing or clearing them
+    bool shared = (this->generation != &this->ownGeneration);
+    const uint64_t *saved = reinterpret_cast<const uint64_t *>(
+            static_cast<const char *>(addr) + sizeof(tableFileHeader));
+    if (header->slots == this->size() && !shared) {
+        for (size_t i = 0; i < this->size(); i++) {
+            this->slots[i].check.store(saved[2*i], std::memory_order_relaxed);
+            this->slots[i].data.store(saved[2*i + 1],
+                    std::memory_order_relaxed);
+        }
+        this->generation->store(header->generation, std::memory_order_relaxed);
+    }
+    else {
+        if (!shared) {
+            this->clear();
+            this->generation->store(header->generation,
+                    std::memory_order_relaxed);
+        }
+        for (uint64_t i = 0; i < header->slots; i++) {
+            uint64_t data = saved[2*i + 1];
+            tableEntry entry;
+            unpack(data, entry);
+            if (data != 0 && entry.bound != boundType::none) {
+                this->store(saved[2*i] ^ data, entry);
+            }
+        }
+    }
+
+    munmap(addr, st.st_size);
+    return true;
+}
+
+size_t othelloTable::size() const {
+    return this->mask + 1;
+}
+
+size_t othelloTable::bytes() const {
+    return this->size() * sizeof(slot);
+}
+
+const std::string &othelloTable::placementError() const {
+    return this->placementMessage;
+}
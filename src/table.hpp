@@ -0,0 +1,182 @@
+#ifndef TABLE_HPP
+#define TABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "heuristic.hpp"
+
+// How a stored score relates to the true value of the position
+enum class boundType : uint8_t {
+    none,
+    exact,
+    lower,      // the true value is at least score
+    upper       // the true value is at most score
+};
+
+struct tableEntry {
+    int score = 0;
+    // Plies searched below the position
+    int depth = 0;
+    boundType bound = boundType::none;
+    // Best move found, or -1
+    int move = -1;
+};
+
+// Header of a table snapshot, followed by the slots as (check, data) pairs.
+// The seed and key check tie a snapshot to the Zobrist keys of the build
+// that wrote it.
+struct tableFileHeader {
+    char magic[8];          // "OTTOHASH"
+    uint32_t version;
+    uint32_t slotSize;
+    uint64_t slots;
+    uint64_t seed;
+    uint64_t keyCheck;
+    uint8_t generation;
+    uint8_t reserved[7];
+};
+
+const char tableFileMagic[8] = {'O', 'T', 'T', 'O', 'H', 'A', 'S', 'H'};
+const uint32_t tableFileVersion = 1;
+
+// Header of a table in a named shared-memory segment, followed by the
+// slots. The generation is shared, so that every attached process ages
+// entries alike.
+struct sharedTableHeader {
+    char magic[8];          // "OTTOSHMT"
+    uint32_t version;
+    uint32_t slotSize;
+    uint64_t slots;
+    uint64_t seed;
+    uint64_t keyCheck;
+    std::atomic<uint8_t> generation;
+    uint8_t reserved[7];
+};
+
+const char sharedTableMagic[8] = {'O', 'T', 'T', 'O', 'S', 'H', 'M', 'T'};
+const uint32_t sharedTableVersion = 1;
+
+// Placement of a table's memory
+struct tableMemory {
+    // Back the table with huge pages: explicit ones if the system has
+    // reserved any, transparent ones otherwise, and normal pages if
+    // neither is available
+    bool hugePages = true;
+    // Spread the pages over all online NUMA nodes. Otherwise the kernel's
+    // default policy applies: each page goes to the node of the thread
+    // that first touches it. Search threads are not pinned to nodes.
+    bool interleave = false;
+};
+
+// Transposition table shared by any number of searching threads, with a
+// fixed memory budget. Entries are written without locks: each slot keeps
+// the key XORed with the data, so a torn write fails verification on
+// probe instead of returning another position's score. The same holds
+// across processes, so a table can also live in shared memory.
+class othelloTable {
+    public:
+        // Allocates the largest power-of-two number of slots that fits in
+        // bytes (at least one). Pages are only touched when they are first
+        // probed or stored.
+        explicit othelloTable(size_t bytes,
+                const tableMemory &memory = tableMemory());
+        ~othelloTable();
+
+        // Attaches to the POSIX shared-memory segment name (such as
+        // "/otto"), creating it with the size othelloTable(bytes) would
+        // have if it does not exist. Every process attached to the same
+        // name searches on the same entries. The segment outlives the
+        // processes until it is unlinked (on Linux, removed from
+        // /dev/shm). Returns nullptr and sets error if the segment cannot
+        // be mapped or was created by a build with other hash keys.
+        static std::unique_ptr<othelloTable> openShared(
+                const std::string &name, size_t bytes, std::string &error,
+                const tableMemory &memory = tableMemory());
+
+        othelloTable(const othelloTable &) = delete;
+        othelloTable &operator=(const othelloTable &) = delete;
+
+        // Zobrist key of a position searched by color with the given
+        // evaluator, where toMove is the side to move. Scores are always
+        // from color's point of view, so color is part of the key.
+        static uint64_t hash(const othelloBoard &board, int toMove, int color,
+                evaluatorType evaluator);
+
+        // Key of a position with toMove to move that is the same for all
+        // eight symmetric boards, regardless of who searches it. symmetry
+        // is set to the transformation that maps board to the board the
+        // key was taken from (see symmetricSquare).
+        static uint64_t canonicalHash(const othelloBoard &board, int toMove,
+                int &symmetry);
+
+        // Square that square maps to under one of the eight symmetries of
+        // the board: bit 0 mirrors the rows, bit 1 the columns and bit 2
+        // then swaps rows and columns
+        static int symmetricSquare(int square, int symmetry);
+        static int inverseSymmetry(int symmetry);
+
+        // Seed of the Zobrist keys and a key derived from it, recorded in
+        // files of keyed positions so that builds with other keys refuse them
+        static uint64_t keySeed();
+        static uint64_t keyCheck();
+
+        bool probe(uint64_t key, tableEntry &entry) const;
+
+        // Starts loading the slot of key into the cache, so that a probe
+        // shortly after does not wait for memory
+        void prefetch(uint64_t key) const {
+            __builtin_prefetch(&this->slots[key & this->mask]);
+        }
+
+        // Keeps the deeper entry when two positions share a slot, unless
+        // the old one is from an earlier search
+        void store(uint64_t key, const tableEntry &entry);
+
+        // Marks the start of a new search, so older entries are replaced
+        // first
+        void newSearch();
+
+        void clear();
+
+        // Writes every slot to fileName. Nothing may store while the
+        // snapshot is written.
+        bool save(const std::string &fileName, std::string &error) const;
+        // Maps a snapshot written by save and copies its entries into the
+        // table, rehashing them if it has another size. A shared table is
+        // never cleared: the entries are merged into those of the other
+        // processes. Returns false and sets error if the file is not a
+        // snapshot of this build's keys.
+        bool load(const std::string &fileName, std::string &error);
+
+        size_t size() const;
+        size_t bytes() const;
+
+        // Why the requested NUMA interleaving could not be applied; empty
+        // if it was, or if it was not requested
+        const std::string &placementError() const;
+
+    private:
+        struct slot {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        // Private or shared mapping holding the slots
+        slot *slots = nullptr;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        size_t mask = 0;
+        std::string placementMessage;
+        std::atomic<uint8_t> ownGeneration{0};
+        std::atomic<uint8_t> *generation = &this->ownGeneration;
+
+        othelloTable() {}
+
+        static uint64_t pack(const tableEntry &entry, uint8_t generation);
+        static void unpack(uint64_t data, tableEntry &entry);
+        static uint8_t generationOf(uint64_t data);
+};
+
+#endif // TABLE_HPP
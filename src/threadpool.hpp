@@ -0,0 +1,110 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <queue>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads. Each task receives the index of the
+// worker running it, so callers can keep per-worker state such as an
+// othelloPlayer and its search stack. Tasks with a lower priority value run
+// first, and tasks of equal priority in submission order.
+class othelloThreadPool {
+    public:
+        explicit othelloThreadPool(int numThreads) {
+            if (numThreads < 1) {
+                numThreads = 1;
+            }
+            for (int i = 0; i < numThreads; i++) {
+                this->workers.emplace_back(&othelloThreadPool::work, this, i);
+            }
+        }
+
+        ~othelloThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->stopping = true;
+            }
+            this->taskReady.notify_all();
+            for (std::thread &worker : this->workers) {
+                worker.join();
+            }
+        }
+
+        othelloThreadPool(const othelloThreadPool &) = delete;
+        othelloThreadPool &operator=(const othelloThreadPool &) = delete;
+
+        int size() const {
+            return this->workers.size();
+        }
+
+        // Queues a task for the next idle worker
+        void submit(std::function<void(int)> task, long long priority = 0) {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->tasks.push({priority, this->submitted++, std::move(task)});
+                this->pending++;
+            }
+            this->taskReady.notify_one();
+        }
+
+        // Blocks until every submitted task has finished
+        void wait() {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->allDone.wait(lock, [this] { return this->pending == 0; });
+        }
+
+    private:
+        struct queuedTask {
+            long long priority;
+            long long sequence;
+            std::function<void(int)> task;
+
+            // Orders the queue so that top() is the task to run next
+            bool operator<(const queuedTask &other) const {
+                return this->priority != other.priority
+                    ? this->priority > other.priority
+                    : this->sequence > other.sequence;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        std::priority_queue<queuedTask> tasks;
+        long long submitted = 0;
+        std::mutex mutex;
+        std::condition_variable taskReady;
+        std::condition_variable allDone;
+        int pending = 0;
+        bool stopping = false;
+
+        void work(int worker) {
+            std::function<void(int)> task;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    this->taskReady.wait(lock, [this] {
+                        return this->stopping || !this->tasks.empty();
+                    });
+                    if (this->tasks.empty()) {
+                        return;
+                    }
+                    task = this->tasks.top().task;
+                    this->tasks.pop();
+                }
+
+                task(worker);
+
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (--this->pending == 0) {
+                        this->allDone.notify_all();
+                    }
+                }
+            }
+        }
+};
+
+#endif // THREADPOOL_HPP
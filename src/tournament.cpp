@@ -0,0 +1,532 @@
+// Engine-vs-engine tournament with Elo and SPRT statistics.
+//
+// Usage: tournament.exe [--a CONFIG] [--b CONFIG] [--games N]
+//                       [--concurrency N] [--openings FILE]
+//                       [--catalogue lib/openings.dat] [--opening-plies 6]
+//                       [--elo0 0] [--elo1 5] [--alpha 0.05] [--beta 0.05]
+//                       [--sprt-stop] [--book] [--report N]
+//                       [--archive FILE]
+//
+// A CONFIG is a comma-separated list of depth=N, time=S, eval=NAME,
+// threads=N, engine=alphabeta|mcts, playouts=N and playout=random|corners,
+// e.g. "depth=6,eval=positional" or "engine=mcts,time=0.1". playouts limits
+// the playouts per move of the Monte-Carlo engine, and playout=corners makes
+// them take corners first. Every opening is played twice with colours
+// swapped (so --games is rounded up to an even number), one game per worker
+// thread. Results are reported from the point
+// of view of engine A, followed by the search speed of each engine: nodes
+// per second, or playouts per second for mcts. --archive writes every game
+// to a game archive (see archive.hpp), with the engine configurations as the
+// player names.
+
+#include <atomic>
+#include <cmath>
+#include "analysis.hpp"
+#include "archive.hpp"
+#include "game.hpp"
+#include "threadpool.hpp"
+
+struct engineConfig {
+    int depth = 0;
+    float time = 0.0;
+    int threads = 1;
+    evaluatorType evaluator = evaluatorType::standard;
+    searchAlgorithm algorithm = searchAlgorithm::alphaBeta;
+    long long playouts = 0;
+    bool biased = false;
+};
+
+// Search work of one engine over the games it played
+struct engineUsage {
+    long long nodes = 0;
+    double time = 0.0;
+
+    engineUsage &operator+=(const engineUsage &other) {
+        this->nodes += other.nodes;
+        this->time += other.time;
+        return *this;
+    }
+};
+
+struct openingPosition {
+    othelloBoard board;
+    int toMove = 1;
+    // Move history for the opening book; empty for set-up positions
+    std::string history;
+};
+
+/**
+ * @brief 解析引擎配置
+ *
+ * @param text 形如 "depth=6,time=0.5,eval=standard,threads=2" 或
+ *             "engine=mcts,playouts=5000,playout=corners" 的配置
+ * @param config 写入解析结果
+ * @return 配置合法时返回 true
+ */
+bool parseConfig(const std::string &text, engineConfig &config) {
+    std::istringstream iss(text);
+    std::string option;
+
+    try {
+        while (std::getline(iss, option, ',')) {
+            size_t eq = option.find('=');
+            if (eq == std::string::npos) {
+                return false;
+            }
+
+            std::string key = option.substr(0, eq);
+            std::string value = option.substr(eq + 1);
+            if (key == "depth") {
+                config.depth = std::stoi(value);
+            }
+            else if (key == "time") {
+                config.time = std::stof(value);
+            }
+            else if (key == "threads") {
+                config.threads = std::stoi(value);
+            }
+            else if (key == "eval") {
+                if (!othelloHeuristic::parseEvaluator(value, config.evaluator)) {
+                    return false;
+                }
+            }
+            else if (key == "engine" && (value == "alphabeta"
+                        || value == "mcts")) {
+                config.algorithm = (value == "mcts") ? searchAlgorithm::mcts
+                    : searchAlgorithm::alphaBeta;
+            }
+            else if (key == "playouts") {
+                config.playouts = std::stoll(value);
+            }
+            else if (key == "playout" && (value == "random"
+                        || value == "corners")) {
+                config.biased = (value == "corners");
+            }
+            else {
+                return false;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        return false;
+    }
+
+    if (config.depth <= 0 && config.time <= 0 && config.playouts <= 0) {
+        config.time = 0.1;
+    }
+    return true;
+}
+
+/**
+ * @brief 由开局目录生成均衡的开局局面
+ *
+ * 将每条开局线截断到 plies 步，去重后在起始局面上摆出。
+ *
+ * @param fileName 开局目录文件
+ * @param plies 开局步数
+ * @param openings 追加生成的开局局面
+ * @return 读取成功时返回 true
+ */
+bool catalogueOpenings(const std::string &fileName, int plies,
+        std::vector<openingPosition> &openings) {
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.good()) {
+        return false;
+    }
+
+    std::vector<std::vector<int>> lines;
+    std::vector<int> squares;
+    std::string line, sequence;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        if (!(iss >> sequence)
+                || !othelloDatabase::parseCatalogueLine(sequence, squares)
+                || (int) squares.size() < plies) {
+            continue;
+        }
+        squares.resize(plies);
+        if (std::find(lines.begin(), lines.end(), squares) == lines.end()) {
+            lines.push_back(squares);
+        }
+    }
+
+    for (const std::vector<int> &moves : lines) {
+        openingPosition opening;
+        opening.board.startPosition();
+
+        bool legal = true;
+        for (int square : moves) {
+            opening.board.findLegalMoves(opening.toMove, &opening.board.moves);
+            auto move = opening.board.moves.find(square);
+            if (move == opening.board.moves.end()) {
+                legal = false;
+                break;
+            }
+            opening.board.updateBoard(opening.toMove, *move);
+            opening.board.discsOnBoard++;
+            opening.history.append(std::to_string(square) + ",");
+            opening.toMove = -opening.toMove;
+        }
+        opening.board.moves.clear();
+
+        if (legal) {
+            openings.push_back(opening);
+        }
+    }
+
+    return true;
+}
+
+void configurePlayer(othelloPlayer &player, const engineConfig &config,
+        bool useBook) {
+    player.computer = true;
+    player.verbose = false;
+    player.useBook = useBook;
+    player.maxDepth = config.depth;
+    player.threads = config.threads;
+    player.setEvaluator(config.evaluator);
+    player.algorithm = config.algorithm;
+    player.maxPlayouts = config.playouts;
+    player.biasedPlayouts = config.biased;
+}
+
+/**
+ * @brief 无终端输出地下完一盘棋
+ *
+ * @param opening 开局局面
+ * @param black 黑方配置
+ * @param white 白方配置
+ * @param useBook 是否使用开局库
+ * @param blackUsage 累加黑方的搜索节点数（或随机对局数）与用时
+ * @param whiteUsage 累加白方的搜索节点数（或随机对局数）与用时
+ * @param record 不为空时写入整盘棋（含开局）的走法，-1 表示弃权
+ * @return 黑方子数减白方子数
+ */
+int playGame(const openingPosition &opening, const engineConfig &black,
+        const engineConfig &white, bool useBook, engineUsage &blackUsage,
+        engineUsage &whiteUsage, gameRecord *record = nullptr) {
+    othelloGame game;
+    game.verbose = false;
+    game.newGame(true, true, 0);
+    game.board.positions = opening.board.positions;
+    game.board.discsOnBoard = opening.board.discsOnBoard;
+    game.toMove = opening.toMove;
+    game.moveHistory = opening.history;
+    configurePlayer(game.blackPlayer, black, useBook);
+    configurePlayer(game.whitePlayer, white, useBook);
+
+    if (record != nullptr) {
+        record->moves.clear();
+        record->start.clear();
+        record->toMove = 1;
+        if (opening.history.empty()) {
+            record->start = opening.board.positions;
+            record->toMove = opening.toMove;
+        }
+        std::istringstream iss(opening.history);
+        std::string square;
+        while (std::getline(iss, square, ',')) {
+            record->moves.push_back(std::stoi(square));
+        }
+    }
+
+    while (!game.gameOver) {
+        game.board.findLegalMoves(game.toMove, &game.board.moves);
+        game.board.timeLimit = (game.toMove == 1) ? black.time : white.time;
+        std::vector<int> before = game.board.positions;
+        game.move(game.toMove);
+        const searchResult &search = (game.toMove == 1)
+            ? game.blackPlayer.lastSearch : game.whitePlayer.lastSearch;
+        engineUsage &usage = (game.toMove == 1) ? blackUsage : whiteUsage;
+        usage.nodes += search.nodes;
+        usage.time += search.time;
+        if (record != nullptr) {
+            // The square that was empty and is not any more, or a pass
+            auto placed = std::mismatch(before.begin(), before.end(),
+                    game.board.positions.begin(),
+                    [](int a, int b) { return a != 0 || b == 0; });
+            record->moves.push_back(placed.first == before.end()
+                    ? -1 : placed.first - before.begin());
+        }
+        game.checkGameOver();
+        game.toMove = -game.toMove;
+    }
+
+    if (record != nullptr) {
+        record->result = finalResult(game.board);
+        record->timeControl = (black.time == white.time)
+            ? (uint32_t) (1000*black.time) : 0;
+    }
+    return std::accumulate(game.board.positions.begin(),
+            game.board.positions.end(), 0);
+}
+
+// Win/draw/loss record of engine A, with Elo and SPRT estimates
+struct tournamentStats {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const {
+        return this->wins + this->draws + this->losses;
+    }
+
+    double score() const {
+        return (this->wins + 0.5*this->draws) / this->games();
+    }
+
+    // Per-game variance of the score
+    double variance() const {
+        double s = this->score();
+        return (this->wins*(1 - s)*(1 - s) + this->draws*(0.5 - s)*(0.5 - s)
+                + this->losses*s*s) / this->games();
+    }
+
+    static double elo(double score) {
+        score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+        return -400*std::log10(1/score - 1);
+    }
+
+    static double expectedScore(double elo) {
+        return 1 / (1 + std::pow(10, -elo/400));
+    }
+
+    // Log-likelihood ratio of H1 (elo1) against H0 (elo0), using the normal
+    // approximation to the trinomial distribution of game results. Until
+    // engine A has both won and lost a game, the variance of the record
+    // says nothing about the variance of the results, and the ratio is 0.
+    double llr(double elo0, double elo1) const {
+        if (this->wins == 0 || this->losses == 0) {
+            return 0;
+        }
+        double var = this->variance();
+        double s0 = expectedScore(elo0), s1 = expectedScore(elo1);
+        return (s1 - s0) * (2*this->games()*this->score()
+                - this->games()*(s0 + s1)) / (2*var);
+    }
+};
+
+void report(const tournamentStats &stats, double elo0, double elo1,
+        double alpha, double beta) {
+    int n = stats.games();
+    double s = stats.score();
+    double margin = 1.96*std::sqrt(stats.variance() / n);
+    double elo = tournamentStats::elo(s);
+    double errorBar = (tournamentStats::elo(s + margin)
+            - tournamentStats::elo(s - margin)) / 2;
+
+    double lower = std::log(beta / (1 - alpha));
+    double upper = std::log((1 - beta) / alpha);
+    double llr = stats.llr(elo0, elo1);
+    std::string verdict = (llr >= upper) ? "H1 accepted (A is stronger)"
+        : (llr <= lower) ? "H0 accepted (A is not stronger)" : "inconclusive";
+
+    std::cout << "Games: " << n << "  W-D-L: " << stats.wins << "-"
+        << stats.draws << "-" << stats.losses << "  Score: " << 100*s << "%"
+        << std::endl;
+    std::cout << "Elo: " << elo << " +/- " << errorBar << " (95%)" << std::endl;
+    std::cout << "SPRT (elo0=" << elo0 << ", elo1=" << elo1 << ", alpha="
+        << alpha << ", beta=" << beta << "): LLR " << llr << " ["
+        << lower << ", " << upper << "] " << verdict << std::endl;
+}
+
+void reportSpeed(const std::string &name, const engineConfig &config,
+        const engineUsage &usage) {
+    bool mcts = (config.algorithm == searchAlgorithm::mcts);
+    std::cout << "Engine " << name << ": " << usage.nodes
+        << (mcts ? " playouts" : " nodes") << " in " << usage.time << "s, "
+        << (long long) (usage.nodes / std::max(usage.time, 1e-6))
+        << (mcts ? " playouts/s" : " nodes/s") << std::endl;
+}
+
+int main(int argc, char **argv) {
+    engineConfig configA, configB;
+    std::string nameA = "A", nameB = "B";
+    std::string openingsFile, catalogue = "../lib/openings.dat", archiveFile;
+    int games = 100, concurrency = std::thread::hardware_concurrency();
+    int plies = 6, reportEvery = 0;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    bool sprtStop = false, useBook = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--sprt-stop") {
+                sprtStop = true;
+                continue;
+            }
+            if (arg == "--book") {
+                useBook = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--a" || arg == "--b") {
+                if (!parseConfig(value, arg == "--a" ? configA : configB)) {
+                    std::cout << "Invalid engine configuration " << value
+                        << std::endl;
+                    return 1;
+                }
+                (arg == "--a" ? nameA : nameB) = value;
+            }
+            else if (arg == "--games") {
+                games = std::stoi(value);
+                if (games < 1) {
+                    throw std::invalid_argument(value);
+                }
+                // Whole pairs, so every opening is played with both colours
+                games += games % 2;
+            }
+            else if (arg == "--concurrency") {
+                concurrency = std::stoi(value);
+            }
+            else if (arg == "--openings") {
+                openingsFile = value;
+            }
+            else if (arg == "--catalogue") {
+                catalogue = value;
+            }
+            else if (arg == "--opening-plies") {
+                plies = std::stoi(value);
+            }
+            else if (arg == "--elo0") {
+                elo0 = std::stod(value);
+            }
+            else if (arg == "--elo1") {
+                elo1 = std::stod(value);
+            }
+            else if (arg == "--alpha") {
+                alpha = std::stod(value);
+            }
+            else if (arg == "--beta") {
+                beta = std::stod(value);
+            }
+            else if (arg == "--report") {
+                reportEvery = std::stoi(value);
+            }
+            else if (arg == "--archive") {
+                archiveFile = value;
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    if (configA.depth <= 0 && configA.time <= 0 && configA.playouts <= 0) {
+        configA.time = 0.1;
+    }
+    if (configB.depth <= 0 && configB.time <= 0 && configB.playouts <= 0) {
+        configB.time = 0.1;
+    }
+
+    std::vector<openingPosition> openings;
+    if (!openingsFile.empty()) {
+        std::vector<analysisTask> tasks;
+        std::string error;
+        if (!readPositions(openingsFile, searchLimits(), tasks, error)) {
+            std::cout << error << std::endl;
+            return 1;
+        }
+        for (const analysisTask &task : tasks) {
+            openingPosition opening;
+            opening.board = task.board;
+            opening.toMove = task.toMove;
+            openings.push_back(opening);
+        }
+    }
+    else if (!catalogueOpenings(catalogue, plies, openings)) {
+        std::cout << "Could not read " << catalogue << std::endl;
+        return 1;
+    }
+    if (openings.empty()) {
+        std::cout << "No openings!" << std::endl;
+        return 1;
+    }
+
+    othelloArchiveWriter archive;
+    if (!archiveFile.empty() && !archive.open(archiveFile)) {
+        std::cout << "Could not write " << archiveFile << std::endl;
+        return 1;
+    }
+
+    std::cout << "Playing " << games << " games from " << openings.size()
+        << " openings on " << concurrency << " threads" << std::endl;
+
+    tournamentStats stats;
+    engineUsage usageA, usageB;
+    std::mutex statsMutex;
+    std::atomic<bool> finished(false);
+    {
+        othelloThreadPool pool(concurrency);
+        for (int i = 0; i < games; i++) {
+            pool.submit([&, i](int) {
+                if (finished) {
+                    return;
+                }
+
+                // Each opening is played twice, A taking black first
+                const openingPosition &opening = openings[(i/2) % openings.size()];
+                bool aIsBlack = (i % 2 == 0);
+                gameRecord record;
+                gameRecord *recordPtr = archiveFile.empty() ? nullptr : &record;
+                engineUsage gameA, gameB;
+                int discs = aIsBlack
+                    ? playGame(opening, configA, configB, useBook, gameA,
+                            gameB, recordPtr)
+                    : -playGame(opening, configB, configA, useBook, gameB,
+                            gameA, recordPtr);
+
+                std::lock_guard<std::mutex> lock(statsMutex);
+                if (finished) {
+                    return;
+                }
+                usageA += gameA;
+                usageB += gameB;
+                if (recordPtr != nullptr) {
+                    record.black = aIsBlack ? nameA : nameB;
+                    record.white = aIsBlack ? nameB : nameA;
+                    archive.add(record);
+                }
+                if (discs > 0) {
+                    stats.wins++;
+                }
+                else if (discs < 0) {
+                    stats.losses++;
+                }
+                else {
+                    stats.draws++;
+                }
+
+                if (reportEvery > 0 && stats.games() % reportEvery == 0) {
+                    report(stats, elo0, elo1, alpha, beta);
+                }
+
+                double llr = stats.llr(elo0, elo1);
+                if (sprtStop && (llr >= std::log((1 - beta) / alpha)
+                            || llr <= std::log(beta / (1 - alpha)))) {
+                    finished = true;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    report(stats, elo0, elo1, alpha, beta);
+    reportSpeed("A", configA, usageA);
+    reportSpeed("B", configB, usageB);
+    if (!archiveFile.empty() && !archive.close()) {
+        std::cout << "Could not write " << archiveFile << std::endl;
+        return 1;
+    }
+    return 0;
+}
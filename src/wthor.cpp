@@ -0,0 +1,342 @@
+// WTHOR game database importer.
+//
+// Usage: wthor.exe [--output FILE] [--positions FILE] [--corpus FILE]
+//                  [--players FILE] [--threads N] FILE.wtb...
+//
+// Memory-maps WTHOR .wtb files, replays every game on the board to check
+// it, and writes the valid games, in input order, to a game archive
+// (--output, see archive.hpp) and every position before a move to a text
+// position file (--positions) in the one-line format of --analyze and/or a
+// binary position corpus (--corpus, see corpus.hpp). Positions are labelled
+// with the final disc difference from the side to move and the move played,
+// as "; RESULT MOVE". Player
+// names are read from a WTHOR.JOU file if --players is given, and are the
+// player numbers otherwise. Files are imported in parallel, one per worker
+// thread.
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "analysis.hpp"
+#include "archive.hpp"
+#include "corpus.hpp"
+#include "threadpool.hpp"
+
+// WTHOR files start with a 16-byte header; .wtb records are 68 bytes and
+// .jou (player) records 20 bytes. Integers are little-endian.
+const size_t wthorHeaderSize = 16;
+const size_t wthorGameSize = 68;
+const size_t wthorPlayerSize = 20;
+
+// Read-only mapping of a whole file
+class mappedFile {
+    public:
+        explicit mappedFile(const std::string &fileName) {
+            int fd = open(fileName.c_str(), O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED,
+                        fd, 0);
+                if (addr != MAP_FAILED) {
+                    this->data = static_cast<const uint8_t *>(addr);
+                    this->size = st.st_size;
+                }
+            }
+            close(fd);
+        }
+
+        ~mappedFile() {
+            if (this->data != nullptr) {
+                munmap(const_cast<uint8_t *>(this->data), this->size);
+            }
+        }
+
+        mappedFile(const mappedFile &) = delete;
+        mappedFile &operator=(const mappedFile &) = delete;
+
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+};
+
+uint16_t read16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+uint32_t read32(const uint8_t *p) {
+    return read16(p) | ((uint32_t) read16(p + 2) << 16);
+}
+
+// Games and positions imported from one file
+struct importResult {
+    std::string error;
+    std::vector<gameRecord> games;
+    std::vector<corpusRecord> positions;
+    long long invalid = 0;
+    long long scoreMismatches = 0;
+};
+
+/**
+ * @brief 读取 WTHOR 棋手名单
+ *
+ * @param fileName WTHOR.JOU 文件
+ * @param players 写入棋手名，下标为棋手编号
+ * @return 读取成功时返回 true
+ */
+bool readPlayers(const std::string &fileName,
+        std::vector<std::string> &players) {
+    mappedFile file(fileName);
+    if (file.data == nullptr || file.size < wthorHeaderSize) {
+        return false;
+    }
+
+    size_t count = (file.size - wthorHeaderSize) / wthorPlayerSize;
+    for (size_t i = 0; i < count; i++) {
+        const char *name = reinterpret_cast<const char *>(file.data
+                + wthorHeaderSize + i*wthorPlayerSize);
+        players.push_back(std::string(name, strnlen(name, wthorPlayerSize)));
+    }
+    return true;
+}
+
+/**
+ * @brief 导入一个 .wtb 文件
+ *
+ * 每盘棋在棋盘上重放：含非法走法的对局计为无效并跳过。对局结束而终局子数差
+ * 与文件中的比分不符时，以终局局面为准并计数；未结束的对局使用文件中的比分。
+ *
+ * @param fileName .wtb 文件
+ * @param players 棋手名，可为空
+ * @param positions 是否同时生成局面
+ * @param result 写入导入结果
+ */
+void importFile(const std::string &fileName,
+        const std::vector<std::string> &players, bool positions,
+        importResult &result) {
+    mappedFile file(fileName);
+    if (file.data == nullptr || file.size < wthorHeaderSize) {
+        result.error = fileName + ": could not read file";
+        return;
+    }
+
+    uint32_t count = read32(file.data + 4);
+    uint8_t boardSize = file.data[12];
+    if ((boardSize != 0 && boardSize != 8) || boardSide != 8
+            || wthorHeaderSize + (uint64_t) count*wthorGameSize > file.size) {
+        result.error = fileName + ": not an 8x8 WTHOR game file";
+        return;
+    }
+    madvise(const_cast<uint8_t *>(file.data), file.size, MADV_SEQUENTIAL);
+
+    othelloBoard board;
+    uint8_t moves[60];
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *record = file.data + wthorHeaderSize + i*wthorGameSize;
+        int black = read16(record + 2), white = read16(record + 4);
+        int score = record[6];
+
+        // Moves are 10*row + column, 1-based, and 0 after the last move
+        gameView game;
+        game.moves = moves;
+        bool valid = true;
+        for (int j = 0; j < 60 && record[8 + j] != 0; j++) {
+            int row = record[8 + j] / 10, col = record[8 + j] % 10;
+            if (row < 1 || row > 8 || col < 1 || col > 8) {
+                valid = false;
+                break;
+            }
+            moves[game.moveCount++] = 8*(row - 1) + col - 1;
+        }
+
+        // The score is black's discs, empty squares counting for the winner
+        game.result = 2*score - 64;
+        int played = 0;
+        if (valid) {
+            valid = othelloArchiveReader::replay(game, board,
+                    [&played](const othelloBoard &, int, int square) {
+                        played += (square != -1) ? 1 : 0;
+                    });
+            // Every move was legal, but the finished game does not match
+            // the score: keep the game with the score of the final position
+            if (!valid && played == game.moveCount) {
+                result.scoreMismatches++;
+                game.result = finalResult(board);
+                valid = true;
+            }
+        }
+        if (!valid) {
+            result.invalid++;
+            continue;
+        }
+
+        if (positions) {
+            othelloArchiveReader::replay(game, board,
+                    [&](const othelloBoard &position, int toMove, int square) {
+                        corpusRecord record = corpusRecord::fromBoard(position,
+                                toMove);
+                        record.score = toMove*game.result;
+                        record.flags = hasScore;
+                        if (square != -1) {
+                            record.move = square;
+                            record.flags |= hasMove;
+                        }
+                        result.positions.push_back(record);
+                    });
+        }
+
+        gameRecord out;
+        out.black = (black < (int) players.size()) ? players[black]
+            : std::to_string(black);
+        out.white = (white < (int) players.size()) ? players[white]
+            : std::to_string(white);
+        out.result = game.result;
+        out.moves.assign(moves, moves + game.moveCount);
+        result.games.push_back(out);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string outputFile, positionsFile, corpusFile, playersFile;
+    int numThreads = std::thread::hardware_concurrency();
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) {
+                inputs.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--output") {
+                outputFile = value;
+            }
+            else if (arg == "--positions") {
+                positionsFile = value;
+            }
+            else if (arg == "--corpus") {
+                corpusFile = value;
+            }
+            else if (arg == "--players") {
+                playersFile = value;
+            }
+            else if (arg == "--threads") {
+                numThreads = std::stoi(value);
+            }
+            else {
+                std::cout << "Unknown option " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &) {
+        std::cout << "Invalid option value" << std::endl;
+        return 1;
+    }
+    if (inputs.empty()) {
+        std::cout << "No input files!" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> players;
+    if (!playersFile.empty() && !readPlayers(playersFile, players)) {
+        std::cout << "Could not read " << playersFile << std::endl;
+        return 1;
+    }
+
+    othelloArchiveWriter archive;
+    if (!outputFile.empty() && !archive.open(outputFile)) {
+        std::cout << "Could not write " << outputFile << std::endl;
+        return 1;
+    }
+    std::ofstream positions;
+    if (!positionsFile.empty()) {
+        positions.open(positionsFile.c_str());
+        if (!positions.good()) {
+            std::cout << "Could not write " << positionsFile << std::endl;
+            return 1;
+        }
+    }
+    othelloCorpusWriter corpus;
+    if (!corpusFile.empty() && !corpus.open(corpusFile)) {
+        std::cout << "Could not write " << corpusFile << std::endl;
+        return 1;
+    }
+
+    // Results are written in input order as soon as all earlier files are
+    // done, and then released
+    std::vector<importResult> results(inputs.size());
+    std::vector<bool> done(inputs.size(), false);
+    size_t next = 0;
+    long long games = 0, invalid = 0, mismatches = 0;
+    bool failed = false;
+    std::mutex mutex;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        othelloThreadPool pool(numThreads);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            pool.submit([&, i](int) {
+                importFile(inputs[i], players,
+                        !positionsFile.empty() || !corpusFile.empty(),
+                        results[i]);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = true;
+                for (; next < inputs.size() && done[next]; next++) {
+                    importResult &result = results[next];
+                    if (!result.error.empty()) {
+                        std::cout << result.error << std::endl;
+                        failed = true;
+                    }
+                    for (const gameRecord &game : result.games) {
+                        if (!outputFile.empty() && !archive.add(game)) {
+                            failed = true;
+                        }
+                    }
+                    for (const corpusRecord &record : result.positions) {
+                        if (!positionsFile.empty()) {
+                            positions << corpusLine(record) << '\n';
+                        }
+                        if (!corpusFile.empty() && !corpus.add(record)) {
+                            failed = true;
+                        }
+                    }
+                    games += result.games.size();
+                    invalid += result.invalid;
+                    mismatches += result.scoreMismatches;
+                    result = importResult();
+                }
+            });
+        }
+        pool.wait();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (!outputFile.empty() && !archive.close()) {
+        std::cout << "Could not write " << outputFile << std::endl;
+        return 1;
+    }
+    if (!corpusFile.empty() && !corpus.close()) {
+        std::cout << "Could not write " << corpusFile << std::endl;
+        return 1;
+    }
+
+    std::cout << inputs.size() << " files, " << games << " games imported, "
+        << invalid << " invalid, " << mismatches << " score mismatches, "
+        << elapsed.count() << "s ("
+        << (long long) (games / std::max(elapsed.count(), 1e-6))
+        << " games/s)" << std::endl;
+    return failed ? 1 : 0;
+}